@@ -0,0 +1,89 @@
+#include "arena.h"
+#include <cstdlib>
+#include <new>
+
+const int Arena::MIN_CLASS_SHIFT;
+const int Arena::NUM_CLASSES;
+
+Arena::Arena(size_t block_size)
+        : blocks(nullptr), cur(nullptr), end(nullptr), block_size(block_size),
+          num_upstream(0), num_fresh(0), num_requests(0) {
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        free_lists[c] = nullptr;
+    }
+}
+
+Arena::~Arena() {
+    release();
+}
+
+// smallest class c such that (16 << c) >= bytes
+int Arena::size_class(size_t bytes) {
+    int c = 0;
+    while (((size_t) 1 << (c + MIN_CLASS_SHIFT)) < bytes) {
+        c++;
+    }
+    return c;
+}
+
+// grabs a block of at least bytes from malloc and links it into the block list
+void* Arena::new_block(size_t bytes) {
+    // the header is padded to 16 bytes so the usable part stays max_align_t aligned
+    const size_t header = (size_t) 1 << MIN_CLASS_SHIFT;
+    Block* block = static_cast<Block*>(std::malloc(header + bytes));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    num_upstream++;
+    block->next = blocks;
+    blocks = block;
+    return reinterpret_cast<char*>(block) + header;
+}
+
+void* Arena::allocate(size_t bytes) {
+    num_requests++;
+    int c = size_class(bytes == 0 ? 1 : bytes);
+    if (c < NUM_CLASSES && free_lists[c] != nullptr) {
+        FreeNode* node = free_lists[c];
+        free_lists[c] = node->next;
+        return node;
+    }
+
+    num_fresh++;
+    size_t chunk = (size_t) 1 << (c + MIN_CLASS_SHIFT);
+    if (chunk > block_size / 4) {
+        // big requests get a block of their own rather than wasting the rest of the current one
+        return new_block(chunk);
+    }
+    if (cur == nullptr || (size_t) (end - cur) < chunk) {
+        cur = static_cast<char*>(new_block(block_size));
+        end = cur + block_size;
+    }
+    void* p = cur;
+    cur += chunk;
+    return p;
+}
+
+void Arena::deallocate(void* p, size_t bytes) {
+    if (p == nullptr) {
+        return;
+    }
+    int c = size_class(bytes == 0 ? 1 : bytes);
+    if (c < NUM_CLASSES) {
+        FreeNode* node = static_cast<FreeNode*>(p);
+        node->next = free_lists[c];
+        free_lists[c] = node;
+    }
+}
+
+void Arena::release() {
+    while (blocks != nullptr) {
+        Block* next = blocks->next;
+        std::free(blocks);
+        blocks = next;
+    }
+    cur = end = nullptr;
+    for (int c = 0; c < NUM_CLASSES; ++c) {
+        free_lists[c] = nullptr;
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef OPSYSPROJ_ARENA_H
+#define OPSYSPROJ_ARENA_H
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <queue>
+#include <vector>
+#include <functional>
+
+/*
+ * Simulation-scoped memory arena.
+ *
+ * Memory is carved out of large blocks with a bump pointer and every request is rounded up to a
+ * power-of-two size class. Freed chunks go onto the free list of their class and are handed back
+ * out before the bump pointer moves again, so once a simulation's containers have grown to their
+ * working size the event loop stops asking for fresh memory at all. Nothing is returned to malloc
+ * until the arena itself is destroyed (or release() is called), which frees every block at once.
+ */
+class Arena {
+public:
+    explicit Arena(size_t block_size = 64 * 1024);
+    ~Arena();
+
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    // frees every block; anything still allocated from the arena becomes invalid
+    void release();
+
+    // number of blocks requested from malloc
+    size_t upstream_allocations() const { return num_upstream; }
+    // number of requests that could not be served from a free list
+    size_t fresh_allocations() const { return num_fresh; }
+    // total number of allocate() calls
+    size_t requests() const { return num_requests; }
+
+private:
+    static const int MIN_CLASS_SHIFT = 4;  // 16 byte chunks, keeps everything max_align_t aligned
+    static const int NUM_CLASSES = 28;
+
+    struct FreeNode { FreeNode* next; };
+    struct Block { Block* next; };
+
+    Block* blocks;
+    char* cur;
+    char* end;
+    size_t block_size;
+    FreeNode* free_lists[NUM_CLASSES];
+
+    size_t num_upstream, num_fresh, num_requests;
+
+    static int size_class(size_t bytes);
+    void* new_block(size_t bytes);
+
+    // not copyable, containers hold pointers into it
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+};
+
+// standard allocator handing out memory from an Arena, so any std container can live in one
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    Arena* arena;
+};
+
+// the engine containers, all backed by an Arena
+template <class T>
+using arena_vector = std::vector<T, ArenaAllocator<T> >;
+
+template <class T>
+using arena_deque = std::deque<T, ArenaAllocator<T> >;
+
+template <class T>
+using arena_queue = std::queue<T, arena_deque<T> >;
+
+template <class K, class V>
+using arena_map = std::map<K, V, std::less<K>, ArenaAllocator<std::pair<const K, V> > >;
+
+template <class T, class Compare>
+using arena_priority_queue = std::priority_queue<T, arena_vector<T>, Compare>;
+
+// builds an empty arena_queue that allocates from arena
+template <class T>
+arena_queue<T> make_arena_queue(Arena& arena) {
+    return arena_queue<T>(std::deque<T, ArenaAllocator<T> >(ArenaAllocator<T>(&arena)));
+}
+
+// builds an empty arena_map that allocates from arena
+template <class K, class V>
+arena_map<K, V> make_arena_map(Arena& arena) {
+    return arena_map<K, V>(std::less<K>(), ArenaAllocator<std::pair<const K, V> >(&arena));
+}
+
+// builds an empty arena_priority_queue that allocates from arena
+template <class T, class Compare>
+arena_priority_queue<T, Compare> make_arena_priority_queue(Arena& arena, const Compare& compare = Compare()) {
+    return arena_priority_queue<T, Compare>(compare, arena_vector<T>(ArenaAllocator<T>(&arena)));
+}
+
+#endif //OPSYSPROJ_ARENA_H
@@ -0,0 +1,117 @@
+#include "chrome_trace.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// s as a JSON string literal
+std::string quoted(const std::string& s) {
+    std::string out = "\"";
+    for (size_t k = 0; k < s.size(); ++k) {
+        const unsigned char c = (unsigned char) s[k];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char) c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += (char) c;
+        }
+    }
+    return out + "\"";
+}
+
+// trace-event timestamps are in microseconds
+long long micros(sim_time ms) {
+    return (long long) ms * 1000;
+}
+
+}
+
+ChromeTraceSink::ChromeTraceSink(const std::string& json_filename, const std::string& stats_filename, int t_cs,
+                                 size_t buffer_size)
+        : buffer(buffer_size), t_cs(t_cs), runs(0), first(true), current(nullptr), announced(false), queue_len(-1) {
+    // the buffer has to be in place before the file is opened for every library to use it
+    if (!buffer.empty()) {
+        json.rdbuf()->pubsetbuf(buffer.data(), (std::streamsize) buffer.size());
+    }
+    json.open(json_filename.c_str(), std::ios::out | std::ios::trunc);
+    stats_file.open(stats_filename.c_str(), std::ios::out | std::ios::trunc);
+    stats = &stats_file;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+}
+
+ChromeTraceSink::~ChromeTraceSink() {
+    json << "\n]}\n";
+}
+
+std::ostream& ChromeTraceSink::begin_event() {
+    json << (first ? "\n" : ",\n");
+    first = false;
+    return json;
+}
+
+void ChromeTraceSink::interval(const TimelineInterval& i) {
+    // the CPU's intervals go on its track, the waits on the process's
+    static const char* const names[NUM_TIMELINE_KINDS] = {nullptr, "switch in", "switch out", "ready", "I/O"};
+    static const char* const categories[NUM_TIMELINE_KINDS] = {"cpu", "switch", "switch", "wait", "io"};
+    const std::string name = i.kind == TL_RUNNING ? current->id(i.pid) : names[i.kind];
+    const int tid = i.kind == TL_READY || i.kind == TL_IO ? i.pid + 1 : 0;
+    begin_event() << "{\"name\":" << quoted(name) << ",\"cat\":\"" << categories[i.kind] << "\",\"ph\":\"X\",\"ts\":"
+                  << micros(i.start) << ",\"dur\":" << micros(i.end - i.start) << ",\"pid\":" << runs << ",\"tid\":"
+                  << tid << "}";
+}
+
+void ChromeTraceSink::begin_run(const Workload& workload) {
+    runs++;
+    current = &workload;
+    announced = false;
+    // the track of each simulated process is named when it first appears there; process h is track h + 1
+    named.assign(workload.size(), 0);
+    builder.reset(new IntervalBuilder(workload.size(), t_cs));
+    queue_len = -1;
+}
+
+EventDrain* ChromeTraceSink::event_drain(const Workload& workload) {
+    begin_run(workload);
+    return this;
+}
+
+void ChromeTraceSink::drain(const EventLog& log) {
+    if (!announced) {
+        announced = true;
+        begin_event() << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << runs << ",\"args\":{\"name\":"
+                      << quoted(log.name()) << "}}";
+        begin_event() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << runs
+                      << ",\"tid\":0,\"args\":{\"name\":\"CPU\"}}";
+    }
+
+    const int n = current->size();
+    for (size_t e = 0; e < log.size(); ++e) {
+        const EventRecord& r = log[e];
+        if (r.queue_len != queue_len) {
+            queue_len = r.queue_len;
+            begin_event() << "{\"name\":\"ready queue\",\"ph\":\"C\",\"ts\":" << micros(r.time()) << ",\"pid\":"
+                          << runs << ",\"args\":{\"processes\":" << queue_len << "}}";
+        }
+        if (r.pid >= 0 && r.pid < n && !named[r.pid]) {
+            named[r.pid] = 1;
+            begin_event() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << runs << ",\"tid\":" << r.pid + 1
+                          << ",\"args\":{\"name\":" << quoted("Process " + current->id(r.pid)) << "}}";
+        }
+        builder->add(r, *this);
+    }
+}
+
+void ChromeTraceSink::events(const Workload& workload, const EventLog& log) {
+    // a log that was not drained is the whole run
+    if (current == nullptr) {
+        begin_run(workload);
+    }
+    drain(log);
+    current = nullptr;
+    builder.reset();
+    std::vector<char>().swap(named);
+}
@@ -0,0 +1,61 @@
+#ifndef OPSYSPROJ_CHROME_TRACE_H
+#define OPSYSPROJ_CHROME_TRACE_H
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "output_sink.h"
+#include "timeline.h"
+
+/*
+ * Writes each run's trace as a Chrome trace-event JSON timeline (chrome://tracing, Perfetto),
+ * and the statistics as text to a second file, like FileSink.
+ *
+ * Every run becomes one trace process named after its algorithm. Its "CPU" track holds a slice
+ * per CPU burst or part of one, with the context switches either side of it, plus a "ready
+ * queue" counter of the queue's length; each simulated process gets a track of its own with
+ * its waits in the ready queue and its I/O. Simulated milliseconds are shown as milliseconds.
+ *
+ * The intervals come from an IntervalBuilder (see timeline.h), so the switches are as
+ * approximate as it makes them. The sink drains the run's EventLog while it is recorded (see
+ * event_drain()), writing each chunk out as it comes, and itself keeps a few words per
+ * simulated process, so peak memory is one chunk of the log however long the run.
+ */
+class ChromeTraceSink : public StreamSink, private IntervalSink, private EventDrain {
+public:
+    ChromeTraceSink(const std::string& json_filename, const std::string& stats_filename, int t_cs,
+                    size_t buffer_size = 1 << 16);
+    ~ChromeTraceSink();
+
+    bool is_open() const { return json.is_open() && stats_file.is_open(); }
+    bool wants_events() const { return true; }
+    EventDrain* event_drain(const Workload& workload);
+    void events(const Workload& workload, const EventLog& log);
+
+private:
+    std::vector<char> buffer;
+    std::ofstream json;
+    std::ofstream stats_file;
+    int t_cs;
+    int runs;                 // runs written so far, each is trace process runs
+    bool first;               // nothing written yet, so the next event needs no separating comma
+
+    // the run being written, from its first chunk to its last
+    const Workload* current;  // its workload, nullptr between runs
+    bool announced;           // its trace process has been named
+    std::vector<char> named;  // by handle, whether the process's track has been named
+    std::unique_ptr<IntervalBuilder> builder;
+    int queue_len;            // the ready queue's length as last written
+
+    // starts the next element of the traceEvents array
+    std::ostream& begin_event();
+    // sets up for writing a run of workload
+    void begin_run(const Workload& workload);
+    // writes the next chunk of the current run's events
+    void drain(const EventLog& log);
+    // writes the interval as a complete ("X") event of trace process runs
+    void interval(const TimelineInterval& i);
+};
+
+#endif //OPSYSPROJ_CHROME_TRACE_H
@@ -0,0 +1,175 @@
+#include "event_log.h"
+#include "trace.h"
+
+const size_t EventLog::DRAIN_RECORDS;
+const size_t EventLog::DRAIN_HANDLES;
+
+static const char* const EVENT_KIND_NAMES[NUM_EVENT_KINDS] = {
+        "start", "end", "arrival", "io-done", "cpu-start", "cpu-resume", "burst-done", "io-block",
+        "terminated", "tau", "preempt", "slice-empty", "slice-preempt", "slice-expired"
+};
+
+const char* event_kind_name(EventKind kind) {
+    return EVENT_KIND_NAMES[kind];
+}
+
+bool parse_event_kind(const std::string& name, EventKind& kind) {
+    for (int k = 0; k < NUM_EVENT_KINDS; ++k) {
+        if (name == EVENT_KIND_NAMES[k]) {
+            kind = (EventKind) k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TraceFilter::add_window(sim_time from, sim_time to) {
+    if (from > to) {
+        std::swap(from, to);
+    }
+    // keep the windows sorted and merge any that touch, so in_window() can binary search
+    std::vector<std::pair<sim_time, sim_time> >::iterator it = std::lower_bound(
+            windows.begin(), windows.end(), std::make_pair(from, std::numeric_limits<sim_time>::min()));
+    it = windows.insert(it, std::make_pair(from, to));
+    if (it != windows.begin() && (it - 1)->second >= from - 1) {
+        --it;
+        it->second = std::max(it->second, to);
+        windows.erase(it + 1);
+    }
+    while (it + 1 != windows.end() && (it + 1)->first - 1 <= it->second) {
+        it->second = std::max(it->second, (it + 1)->second);
+        windows.erase(it + 1);
+    }
+}
+
+void TraceFilter::add_kind(EventKind kind) {
+    if (!kinds_set) {
+        kind_mask = 0;
+        kinds_set = true;
+    }
+    kind_mask |= 1u << kind;
+}
+
+void TraceFilter::add_process(int h, int num_handles) {
+    processes.resize(num_handles, 0);
+    processes[h] = 1;
+}
+
+// last window starting at or before time, then check time is not past its end
+bool TraceFilter::in_window(sim_time time) const {
+    std::vector<std::pair<sim_time, sim_time> >::const_iterator it = std::upper_bound(
+            windows.begin(), windows.end(), std::make_pair(time, std::numeric_limits<sim_time>::max()));
+    return it != windows.begin() && time <= (it - 1)->second;
+}
+
+// "Process <id>" plus the tau / priority tag when the record carries one
+static void append_process(TraceLine& line, const Workload& workload, const EventRecord& r) {
+    line << "Process " << workload.id(r.pid);
+    if (r.flags & EVF_TAU) {
+        line << " (tau " << r.tag << "ms)";
+    } else if (r.flags & EVF_PRIO) {
+        line << " (prio " << r.tag << ')';
+    }
+}
+
+void EventLog::render(const Workload& workload, std::ostream& out, sim_time from, sim_time to) const {
+    const std::string name(algorithm);
+    TraceLine line;
+
+    for (size_t e = 0; e < records.size(); ++e) {
+        const EventRecord& r = records[e];
+        const sim_time time = r.time();
+        if (time < from || time > to) {
+            continue;
+        }
+
+        line.start(time);
+        switch (r.kind) {
+            case EV_SIM_START:
+                line << "Simulator started for " << name;
+                break;
+            case EV_SIM_END:
+                line << "Simulator ended for " << name;
+                break;
+            case EV_ARRIVAL:
+                append_process(line, workload, r);
+                line << " arrived; added to ready queue";
+                break;
+            case EV_IO_DONE:
+                append_process(line, workload, r);
+                line << " completed I/O; added to ready queue";
+                break;
+            case EV_CPU_START:
+                append_process(line, workload, r);
+                line << " started using the CPU for " << r.a << "ms burst";
+                break;
+            case EV_CPU_RESUME:
+                append_process(line, workload, r);
+                line << " started using the CPU for remaining " << r.a << "ms of " << r.b << "ms burst";
+                break;
+            case EV_BURST_DONE:
+                append_process(line, workload, r);
+                line << " completed a CPU burst; " << r.a << " burst"
+                     << plural((r.flags & EVF_ALWAYS_PLURAL) ? 2 : r.a) << " to go";
+                break;
+            case EV_IO_BLOCK:
+                append_process(line, workload, r);
+                line << " switching out of CPU; blocking on I/O until time " << time + r.a << "ms";
+                break;
+            case EV_TERMINATED:
+                append_process(line, workload, r);
+                line << " terminated";
+                break;
+            case EV_TAU_RECALC:
+                line << "Recalculated tau for process " << workload.id(r.pid) << ": old tau " << r.a
+                     << "ms ==> new tau " << r.b << "ms";
+                break;
+            case EV_PREEMPT:
+                append_process(line, workload, r);
+                if (r.b == EV_ARRIVAL) {
+                    line << " arrived;";
+                } else if (r.b == EV_IO_DONE) {
+                    line << " completed I/O;";
+                }
+                line << " preempting " << workload.id(r.a);
+                break;
+            case EV_SLICE_EMPTY:
+                line << "Time slice expired; no preemption because ready queue is empty";
+                break;
+            case EV_SLICE_PREEMPT:
+                line << "Time slice expired; preempting process " << workload.id(r.pid) << " with " << r.a
+                     << "ms remaining";
+                break;
+            case EV_SLICE_EXPIRED:
+                line << "Time slice expired; moving process " << workload.id(r.pid) << " to expired array with "
+                     << r.a << "ms remaining";
+                break;
+        }
+
+        line << " [Q";
+        if (r.queue_len == 0) {
+            line << " empty";
+        } else {
+            const int* q = queue(r);
+            for (int k = 0; k < r.queue_len; ++k) {
+                line << ' ' << workload.id(q[k]);
+            }
+        }
+        line << "]\n";
+        line.write_to(out);
+    }
+}
+
+void EventLog::flush() {
+    drain->drain(*this);
+    records.clear();
+    std::copy(queue_pool.begin() + last_offset, queue_pool.begin() + last_offset + last_len, queue_pool.begin());
+    queue_pool.resize(last_len);
+    last_offset = 0;
+}
+
+void EventLog::clear() {
+    records.clear();
+    queue_pool.clear();
+    last_offset = last_len = 0;
+}
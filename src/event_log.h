@@ -0,0 +1,224 @@
+#ifndef OPSYSPROJ_EVENT_LOG_H
+#define OPSYSPROJ_EVENT_LOG_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "sim_time.h"
+#include "workload.h"
+
+// what happened, the meaning of EventRecord::a and ::b is listed next to each kind
+enum EventKind {
+    EV_SIM_START,       // "Simulator started for <algorithm>"
+    EV_SIM_END,         // "Simulator ended for <algorithm>"
+    EV_ARRIVAL,         // pid arrived and was added to the ready queue
+    EV_IO_DONE,         // pid completed I/O and was added to the ready queue
+    EV_CPU_START,       // pid started a CPU burst of a ms
+    EV_CPU_RESUME,      // pid resumed a CPU burst with a ms of its b ms left
+    EV_BURST_DONE,      // pid completed a CPU burst, a bursts to go
+    EV_IO_BLOCK,        // pid switched out of the CPU, blocked on I/O for a ms from the event's time
+    EV_TERMINATED,      // pid finished its last burst
+    EV_TAU_RECALC,      // pid's tau went from a to b
+    EV_PREEMPT,         // pid preempted process a, b is EV_ARRIVAL / EV_IO_DONE when that caused it, else -1
+    EV_SLICE_EMPTY,     // time slice expired with nobody waiting
+    EV_SLICE_PREEMPT,   // time slice expired, pid preempted with a ms left
+    EV_SLICE_EXPIRED,   // time slice expired, pid moved to the expired array with a ms left
+    NUM_EVENT_KINDS
+};
+
+// short name of each kind as used on the command line, e.g. "arrival" or "cpu-start"
+const char* event_kind_name(EventKind kind);
+// looks a name up, returns false if there is no such kind
+bool parse_event_kind(const std::string& name, EventKind& kind);
+
+// EventRecord::flags
+enum {
+    EVF_TAU = 1,             // tag is the process's tau, shown as "(tau Nms)"
+    EVF_PRIO = 2,            // tag is the process's priority, shown as "(prio N)"
+    EVF_ALWAYS_PLURAL = 4    // SJF always says "bursts to go"
+};
+
+/*
+ * Fixed-size binary record of one trace event.
+ *
+ * The ready queue is not copied into the record; queue_offset / queue_len point at a
+ * snapshot in the log's queue pool, which consecutive events share while the queue
+ * does not change. The time is split into a low word and 16 high bits kept where padding
+ * would otherwise go, so a 64-bit clock (48 bits of it, some 8900 years in ms) still fits
+ * two records to a cache line.
+ */
+struct EventRecord {
+    unsigned time_low;
+    int pid;            // handle of the process the event is about, -1 for none
+    int a, b;           // kind-specific arguments, see EventKind
+    int tag;            // tau or priority printed after the pid, see flags
+    int queue_offset;
+    int queue_len;
+    unsigned char kind;
+    unsigned char flags;
+    unsigned short time_high;
+
+    sim_time time() const { return (sim_time) (((unsigned long long) time_high << 32) | time_low); }
+    void set_time(sim_time t) {
+        time_low = (unsigned) t;
+        time_high = (unsigned short) ((unsigned long long) t >> 32);
+    }
+
+    EventRecord& with_tau(int tau) {
+        flags |= EVF_TAU;
+        tag = tau;
+        return *this;
+    }
+    EventRecord& with_prio(int prio) {
+        flags |= EVF_PRIO;
+        tag = prio;
+        return *this;
+    }
+};
+
+static_assert(sizeof(EventRecord) == 32, "EventRecord should stay two to a cache line");
+
+/*
+ * Runtime selection of which events a log keeps: any number of [from, to] time windows,
+ * a set of processes and a set of event kinds. Each part is optional and an empty part
+ * lets everything through; an event is kept when it passes all three. Events that are not
+ * about a single process (start / end, "ready queue is empty") pass the process check.
+ *
+ * The check runs in EventLog::record() before the queue is snapshotted, so a narrow filter
+ * on a huge run costs a few compares per event and the log only holds what was asked for.
+ */
+class TraceFilter {
+public:
+    TraceFilter() : kind_mask(~0u), kinds_set(false) {}
+
+    void add_window(sim_time from, sim_time to);
+    void add_kind(EventKind kind);
+    // selects process handle h out of a workload with num_handles processes
+    void add_process(int h, int num_handles);
+
+    bool has_windows() const { return !windows.empty(); }
+
+    bool accepts(sim_time time, EventKind kind, int pid) const {
+        if (!(kind_mask & (1u << kind))) {
+            return false;
+        }
+        if (pid >= 0 && !processes.empty() && !processes[pid]) {
+            return false;
+        }
+        return windows.empty() || in_window(time);
+    }
+
+private:
+    unsigned kind_mask;  // bit k set when EventKind k is kept
+    bool kinds_set;
+    std::vector<char> processes;  // indexed by handle, empty means every process
+    std::vector<std::pair<sim_time, sim_time> > windows;  // sorted by start, never overlapping
+
+    bool in_window(sim_time time) const;
+};
+
+class EventLog;
+
+// takes events off a log while the run is still recording them (see EventLog::set_drain())
+class EventDrain {
+public:
+    virtual ~EventDrain() {}
+    // log holds every event since the last drain, in order; they are dropped once this returns
+    virtual void drain(const EventLog& log) = 0;
+};
+
+/*
+ * Append buffer of EventRecords written by a scheduler while it simulates.
+ *
+ * Recording an event is a 32 byte append plus, when the ready queue changed, a copy of
+ * its handles; no text is produced. render() turns any time window of the log into the
+ * exact lines the schedulers used to print, so formatting is only paid for on the part
+ * of a run somebody actually reads.
+ *
+ * With a drain set the log is handed to it whenever DRAIN_RECORDS events or DRAIN_HANDLES
+ * queued handles have piled up, and emptied, so however long the run the log never holds more
+ * than one chunk; whoever reads it at the end of the run only gets the last one.
+ */
+class EventLog {
+public:
+    static const size_t DRAIN_RECORDS = 1 << 14;
+    static const size_t DRAIN_HANDLES = 1 << 16;
+
+    explicit EventLog(const char* algorithm)
+            : algorithm(algorithm), filter(nullptr), drain(nullptr), discarded(), last_offset(0), last_len(0) {}
+
+    // only events the filter accepts are kept from now on, nullptr keeps everything
+    void set_filter(const TraceFilter* f) { filter = f; }
+    // hands the events to d a chunk at a time from now on, nullptr keeps them all
+    void set_drain(EventDrain* d) { drain = d; }
+
+    // appends an event along with the ready queue [first, last) as it stands right now
+    template <class It>
+    EventRecord& record(sim_time time, EventKind kind, int pid, int a, int b, It first, It last) {
+        if (filter != nullptr && !filter->accepts(time, kind, pid)) {
+            return discarded;
+        }
+        // drained before appending rather than after, so the caller can still tag the record
+        if (drain != nullptr &&
+            (records.size() >= DRAIN_RECORDS || queue_pool.size() - last_len >= DRAIN_HANDLES)) {
+            flush();
+        }
+        EventRecord r;
+        r.set_time(time);
+        r.pid = pid;
+        r.a = a;
+        r.b = b;
+        r.tag = 0;
+        r.kind = (unsigned char) kind;
+        r.flags = 0;
+        snapshot_queue(first, last);
+        r.queue_offset = last_offset;
+        r.queue_len = last_len;
+        records.push_back(r);
+        return records.back();
+    }
+
+    // writes the events with from <= time <= to as text
+    void render(const Workload& workload, std::ostream& out, sim_time from = std::numeric_limits<sim_time>::min(),
+                sim_time to = std::numeric_limits<sim_time>::max()) const;
+
+    void clear();
+
+    size_t size() const { return records.size(); }
+    const EventRecord& operator[](size_t i) const { return records[i]; }
+    const int* queue(const EventRecord& r) const { return queue_pool.data() + r.queue_offset; }
+    // every queue snapshot, back to back; records point into it with queue_offset / queue_len
+    const std::vector<int>& queues() const { return queue_pool; }
+    const char* name() const { return algorithm; }
+
+private:
+    const char* algorithm;
+    const TraceFilter* filter;
+    EventDrain* drain;
+    EventRecord discarded;  // handed back for filtered out events, so callers can still tag them; zeroed, never read
+    std::vector<EventRecord> records;
+    std::vector<int> queue_pool;
+    int last_offset, last_len;  // the most recent snapshot, reused while the queue is unchanged
+
+    // hands the records to the drain and drops them, keeping the latest snapshot for the next record
+    void flush();
+
+    template <class It>
+    void snapshot_queue(It first, It last) {
+        int len = (int) std::distance(first, last);
+        if (len == last_len && std::equal(first, last, queue_pool.begin() + last_offset)) {
+            return;
+        }
+        last_offset = (int) queue_pool.size();
+        last_len = len;
+        queue_pool.insert(queue_pool.end(), first, last);
+    }
+};
+
+#endif //OPSYSPROJ_EVENT_LOG_H
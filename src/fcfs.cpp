@@ -1,49 +1,69 @@
 #include "fcfs.h"
+#include "perf_counters.h"
+#include "run_budget.h"
 #include <iostream>
 #include <queue>
 #include <iomanip>
-#include <fstream>
 #include <string>
 #include <map>
 #include <cmath>
 #include <algorithm>
 
 
-void fcfs::sim_and_print() {
-    std::sort(processes.begin(), processes.end(), compare_by_arrival_time);
-    print_line("Simulator started for FCFS");
+template <class Trace>
+void fcfs::run() {
+    const int n = workload.size();
+    if (Trace::counted) {
+        counters->handled(EV_SIM_START);
+    }
+    if (Trace::enabled) {
+        log_event(EV_SIM_START);
+    }
 
-    std::map<int, Process> io_bound_map;
-    std::priority_queue<int, std::vector<int>, std::greater<int> > io_bound_map_keys;
-    std::queue<int> times_entered_q;
+    // (completion time, process) of everyone blocked on I/O, a map keyed on time alone lost
+    // one of two processes finishing I/O at the same millisecond
+    arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > > io_queue =
+            make_arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > >(arena);
+    arena_queue<sim_time> times_entered_q = make_arena_queue<sim_time>(arena);
     bool cpu_free = true;
     int i = 0;
-    Process using_cpu;
-    int time_cpu_frees = -1;
+    int using_cpu = -1;
+    sim_time time_cpu_frees = -1;
     int processes_killed = 0;
 
-    int total_cpu_time = 0;
+    long long total_cpu_time = 0;
 //    int total_cpu_bursts = 0, total_io_bursts = 0;
 
     // Separate tracking for CPU-bound and I/O-bound processes
-    int cpu_bound_wait_time = 0, io_bound_wait_time = 0;
-    int cpu_bound_turnaround_time = 0, io_bound_turnaround_time = 0;
+    long long cpu_bound_wait_time = 0, io_bound_wait_time = 0;
+    long long cpu_bound_turnaround_time = 0, io_bound_turnaround_time = 0;
     int cpu_bound_context_switches = 0, io_bound_context_switches = 0;
 
     // while there are processes alive
-    while (processes_killed < (int) processes.size()) {
+    while (processes_killed < n) {
         bool did_something = false;
+        if (Trace::counted) {
+            counters->iterations++;
+        }
+        if (budget != nullptr && budget->spent()) {
+            break;  // out of time, the caller throws the statistics away
+        }
 
-        if (i < (int) processes.size()) {
-            int curr_arrival = processes[i].arrival_time;
-            if (curr_arrival >= elapsed_time && (time_cpu_frees == -1 || curr_arrival <= time_cpu_frees) &&
-                (io_bound_map_keys.empty() || curr_arrival <= io_bound_map_keys.top())) {
+        if (i < n) {
+            int curr_arrival = workload.arrival_time(i);
+            // an arrival that fell inside a switch-out is still let in, it used to be skipped for good
+            if ((time_cpu_frees == -1 || curr_arrival <= time_cpu_frees) &&
+                (io_queue.empty() || curr_arrival <= io_queue.top().first)) {
 
-                q.push(processes[i]);
-                elapsed_time = processes[i].arrival_time;
+                q.push_back(i);
+                elapsed_time = workload.arrival_time(i);
                 times_entered_q.push(elapsed_time);
-                if (elapsed_time <= 9999) {
-                    print_line("Process " + processes[i].id + " arrived; added to ready queue");
+                if (Trace::counted) {
+                    counters->ready_pushed(q.size());
+                    counters->handled(EV_ARRIVAL);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(EV_ARRIVAL, i);
                 }
                 i++;
                 did_something = true;
@@ -52,34 +72,37 @@ void fcfs::sim_and_print() {
 
         if (cpu_free && !q.empty()) {
             cpu_free = false;
-            int wait_time = elapsed_time - times_entered_q.front();
+            sim_time wait_time = elapsed_time - times_entered_q.front();
             elapsed_time += context_switch_time / 2;
             using_cpu = q.front();
-            q.pop();
+            q.pop_front();
             times_entered_q.pop();
 
-            if (using_cpu.is_cpu_bound) {
+            if (state[using_cpu].cpu_bound) {
                 cpu_bound_wait_time += wait_time;
             } else {
                 io_bound_wait_time += wait_time;
             }
 
-            time_cpu_frees = using_cpu.bursts.front() + elapsed_time;
-            if (elapsed_time <= 9999) {
-                print_line("Process " + using_cpu.id + " started using the CPU for " +
-                           std::to_string(using_cpu.bursts.front()) + "ms burst");
+            time_cpu_frees = front_burst(using_cpu) + elapsed_time;
+            if (Trace::counted) {
+                counters->ready_popped();
+                counters->handled(EV_CPU_START);
+            }
+            if (Trace::windowed(elapsed_time)) {
+                log_event(EV_CPU_START, using_cpu, front_burst(using_cpu));
             }
-            int turn_around = using_cpu.bursts.front() + context_switch_time;
-            if (using_cpu.is_cpu_bound) {
+            int turn_around = front_burst(using_cpu) + context_switch_time;
+            if (state[using_cpu].cpu_bound) {
                 cpu_bound_turnaround_time += turn_around;
             } else {
                 io_bound_turnaround_time += turn_around;
             }
 
-            total_cpu_time += using_cpu.bursts.front();
-            using_cpu.bursts.erase(using_cpu.bursts.begin());
+            total_cpu_time += front_burst(using_cpu);
+            state[using_cpu].cursor++;
 
-            if (using_cpu.is_cpu_bound) {
+            if (state[using_cpu].cpu_bound) {
                 cpu_bound_context_switches++;
             } else {
                 io_bound_context_switches++;
@@ -89,23 +112,25 @@ void fcfs::sim_and_print() {
         }
 
         if (!did_something || time_cpu_frees == elapsed_time ||
-            (!io_bound_map_keys.empty() && io_bound_map_keys.top() == elapsed_time)) {
-            if (time_cpu_frees > 0 && time_cpu_frees <= (!io_bound_map_keys.empty() ? io_bound_map_keys.top() : time_cpu_frees)) {
+            (!io_queue.empty() && io_queue.top().first == elapsed_time)) {
+            if (time_cpu_frees > 0 && time_cpu_frees <= (!io_queue.empty() ? io_queue.top().first : time_cpu_frees)) {
                 elapsed_time = time_cpu_frees;
                 time_cpu_frees = -1;
                 cpu_free = true;
 
-                int burst = using_cpu.bursts.front();
-                if (elapsed_time <= 9999 && using_cpu.bursts.size() > 0) {
-                    print_line("Process " + using_cpu.id + " completed a CPU burst; " +
-                               std::to_string((using_cpu.bursts.size() / 2)) + " burst" +
-                               ((using_cpu.bursts.size() / 2) > 1 ? "s" : "") + " to go");
-                    print_line("Process " + using_cpu.id + " switching out of CPU; blocking on I/O until time " +
-                               std::to_string(elapsed_time + burst + (context_switch_time / 2)) + "ms");
+                int burst = front_burst(using_cpu);
+                if (Trace::windowed(elapsed_time) && bursts_left(using_cpu) > 0) {
+                    log_event(EV_BURST_DONE, using_cpu, bursts_left(using_cpu) / 2);
+                    log_event(EV_IO_BLOCK, using_cpu, burst + (context_switch_time / 2));
                 }
 
-                if (using_cpu.bursts.empty()) {
-                    print_line("Process " + using_cpu.id + " terminated");
+                if (bursts_left(using_cpu) == 0) {
+                    if (Trace::counted) {
+                        counters->handled(EV_TERMINATED);
+                    }
+                    if (Trace::enabled) {
+                        log_event(EV_TERMINATED, using_cpu);
+                    }
                     processes_killed++;
 //                    int turnaround_time = elapsed_time - using_cpu.arrival_time;
 //                    if (using_cpu.is_cpu_bound) {
@@ -114,25 +139,40 @@ void fcfs::sim_and_print() {
 //                        io_bound_turnaround_time += turnaround_time;
 //                    }
                 } else {
-                    using_cpu.bursts.erase(using_cpu.bursts.begin());
-                    io_bound_map[elapsed_time + burst + (context_switch_time / 2)] = using_cpu;
-                    io_bound_map_keys.push(elapsed_time + burst + (context_switch_time / 2));
+                    state[using_cpu].cursor++;
+                    io_queue.push(std::make_pair(elapsed_time + burst + (context_switch_time / 2), using_cpu));
+                    if (Trace::counted) {
+                        counters->handled(EV_BURST_DONE);
+                        counters->handled(EV_IO_BLOCK);
+                        counters->io_pushed(io_queue.size());
+                    }
                 }
                 elapsed_time += context_switch_time / 2;
-            } else if (io_bound_map_keys.size() > 0 && (time_cpu_frees >= io_bound_map_keys.top() || time_cpu_frees == -1)) {
-                elapsed_time = io_bound_map_keys.top();
-                q.push(io_bound_map[elapsed_time]);
+            } else if (!io_queue.empty() && (time_cpu_frees >= io_queue.top().first || time_cpu_frees == -1)) {
+                elapsed_time = io_queue.top().first;
+                int from_io = io_queue.top().second;
+                io_queue.pop();
+                q.push_back(from_io);
                 times_entered_q.push(elapsed_time);
-                if (elapsed_time <= 9999) {
-                    print_line("Process " + io_bound_map[elapsed_time].id + " completed I/O; added to ready queue");
+                if (Trace::counted) {
+                    counters->ready_pushed(q.size());
+                    counters->handled(EV_IO_DONE);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(EV_IO_DONE, from_io);
                 }
-                io_bound_map.erase(elapsed_time);
-                io_bound_map_keys.pop();
             }
         }
     }
 
-    print_line("Simulator ended for FCFS");
+    if (Trace::enabled) {
+        log_event(EV_SIM_END);
+    }
+    if (Trace::counted) {
+        counters->handled(EV_SIM_END);
+        counters->preemptions = cpu_preempt + io_preempt;
+        counters->take_memory(arena);
+    }
 
     cpu_util = (double)total_cpu_time / elapsed_time;
     cpu_turn = (double)cpu_bound_turnaround_time / cpu_bound_context_switches;
@@ -147,42 +187,57 @@ void fcfs::sim_and_print() {
     num_io_switches = io_bound_context_switches;
 }
 
-std::string fcfs::get_queue_status() {
-    std::string result = "[Q";
-    if (q.empty()) {
-        result.append(" empty]");
-    } else {
-        std::queue<Process> temp = q;
-        while(!temp.empty()) {
-            result.append(" " + temp.front().id);
-            temp.pop();
-        }
-        result.append("]");
+// runs the event loop instantiated for the requested trace level, keeping only what filter accepts,
+// and the counted one of it when there are counters to fill in
+void fcfs::simulate(TraceLevel level, const TraceFilter* filter, PerfCounters* counters, RunBudget* budget) {
+    log.set_filter(filter);
+    this->counters = counters;
+    this->budget = budget;
+    switch (level) {
+        case TRACE_OFF:
+            counters != nullptr ? run<Counted<TraceOff> >() : run<TraceOff>();
+            break;
+        case TRACE_CUTOFF:
+            counters != nullptr ? run<Counted<TraceCutoff> >() : run<TraceCutoff>();
+            break;
+        case TRACE_FULL:
+            counters != nullptr ? run<Counted<TraceFull> >() : run<TraceFull>();
+            break;
     }
+}
 
-    return result;
+SimStats fcfs::statistics() const {
+    SimStats stats;
+    stats.cpu_util = cpu_util;
+    stats.cpu_wait = cpu_wait;
+    stats.io_wait = io_wait;
+    stats.tot_wait = tot_wait;
+    stats.cpu_turn = cpu_turn;
+    stats.io_turn = io_turn;
+    stats.tot_turn = tot_turn;
+    stats.num_cpu_switches = num_cpu_switches;
+    stats.num_io_switches = num_io_switches;
+    stats.cpu_preempt = cpu_preempt;
+    stats.io_preempt = io_preempt;
+    return stats;
 }
 
-void fcfs::write_statistics(const std::string& filename) const {
+void fcfs::write_statistics(const SimStats& stats, std::ostream& outfile) {
     // TODO: Fix bugs with data collection for this
-    std::fstream outfile(filename, std::ios::app);
 
     outfile << "Algorithm FCFS" << std::endl;
-    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (std::ceil(cpu_util * 100000) / 1000) << "%" << std::endl;
-    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << cpu_wait << " ms" << std::endl;
-    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << io_wait << " ms" << std::endl;
-    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << tot_wait << " ms" << std::endl;
-    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << cpu_turn << " ms" << std::endl;
-    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << io_turn << " ms" << std::endl;
-    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << tot_turn << " ms" << std::endl;
-    outfile << "-- CPU-bound number of context switches: " << num_cpu_switches << std::endl;
-    outfile << "-- I/O-bound number of context switches: " << num_io_switches << std::endl;
-    outfile << "-- overall number of context switches: " << num_cpu_switches + num_io_switches << std::endl;
-    outfile << "-- CPU-bound number of preemptions: " << cpu_preempt << std::endl;
-    outfile << "-- I/O-bound number of preemptions: " << io_preempt << std::endl;
-    outfile << "-- overall number of preemptions: " << cpu_preempt + io_preempt << std::endl << std::endl;
-
-//    outfile.flush();
-    outfile.close();
+    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (std::ceil(stats.cpu_util * 100000) / 1000) << "%" << std::endl;
+    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << stats.cpu_wait << " ms" << std::endl;
+    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << stats.io_wait << " ms" << std::endl;
+    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << stats.tot_wait << " ms" << std::endl;
+    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.cpu_turn << " ms" << std::endl;
+    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.io_turn << " ms" << std::endl;
+    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << stats.tot_turn << " ms" << std::endl;
+    outfile << "-- CPU-bound number of context switches: " << stats.num_cpu_switches << std::endl;
+    outfile << "-- I/O-bound number of context switches: " << stats.num_io_switches << std::endl;
+    outfile << "-- overall number of context switches: " << stats.num_cpu_switches + stats.num_io_switches << std::endl;
+    outfile << "-- CPU-bound number of preemptions: " << stats.cpu_preempt << std::endl;
+    outfile << "-- I/O-bound number of preemptions: " << stats.io_preempt << std::endl;
+    outfile << "-- overall number of preemptions: " << stats.cpu_preempt + stats.io_preempt << std::endl << std::endl;
 }
 
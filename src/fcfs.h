@@ -5,46 +5,69 @@
 #include <iostream>
 #include <string>
 #include "rng.h"
-#include "process.h"
+#include "workload.h"
+#include "arena.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "sim_stats.h"
 #include <queue>
 #include <cmath>
 #include <algorithm>
 
-
+struct PerfCounters;
+class RunBudget;
 
 
 class fcfs {
 public:
-    //constructor
-    fcfs(const std::vector<Process>& processes, int context_switch_time)
-        : processes(processes), context_switch_time(context_switch_time), elapsed_time(0), cpu_util(0.0),
+    // sets up the run, simulate() runs it
+    fcfs(const Workload& workload, int context_switch_time)
+        : workload(workload), state(workload.initial_state(0)), q(ArenaAllocator<int>(&arena)), log("FCFS"), counters(nullptr), budget(nullptr), context_switch_time(context_switch_time), elapsed_time(0), cpu_util(0.0),
         cpu_wait(0.0), io_wait(0.0), tot_wait(0.0), cpu_turn(0.0), io_turn(0.0), tot_turn(0.0), num_cpu_switches(0), num_io_switches(0),
-        cpu_preempt(0), io_preempt(0) {
-        sim_and_print();
-    }
-
-    // getters
-    void sim_and_print();
-    void write_statistics(const std::string& filename) const;
-//    void write_statistics(const std::string& filename) const;
+        cpu_preempt(0), io_preempt(0) {}
 
+    // with counters given, the run also fills them in (see perf_counters.h); with a budget it stops
+    // once that is spent (see run_budget.h)
+    void simulate(TraceLevel level = TRACE_CUTOFF, const TraceFilter* filter = nullptr,
+                  PerfCounters* counters = nullptr, RunBudget* budget = nullptr);
+    SimStats statistics() const;
+    // writes the FCFS block for stats to out, whether the simulator or fcfs_fast_statistics() produced them
+    static void write_statistics(const SimStats& stats, std::ostream& out);
+    // the arena the engine containers allocate from, to check the event loop stays allocation-free
+    const Arena& memory() const { return arena; }
+    // everything the simulation traced, render() it to get the text
+    const EventLog& events() const { return log; }
+    // the same log, for handing it a drain (see EventLog::set_drain()) before simulate()
+    EventLog& events() { return log; }
+//
 private:
-    std::vector<Process> processes;
-    std::queue<Process> q; /* this would be a p queue for other algos */
-    int context_switch_time, elapsed_time;
+    // the event loop, instantiated once per trace policy (see trace_policy.h)
+    template <class Trace>
+    void run();
+
+    const Workload& workload;
+    std::vector<ProcState> state; // hot per-process state, indexed by handle
+    Arena arena; // everything the simulation allocates, freed when the scheduler goes away
+    arena_deque<int> q; /* this would be a p queue for other algos */
+    EventLog log; // trace of the run, rendered on demand
+    PerfCounters* counters; // what a counted run fills in, nullptr otherwise
+    RunBudget* budget;      // stops the run when spent, nullptr for no limit
+    int context_switch_time;
+    sim_time elapsed_time;
     double cpu_util, cpu_wait, io_wait, tot_wait, cpu_turn, io_turn, tot_turn;
     int num_cpu_switches, num_io_switches, cpu_preempt, io_preempt;
-    // helper function to get the end-of-line queue status updates
-    std::string get_queue_status();
-    // helper function to make our outputting to cout easier
-    void print_line(const std::string& message) {
-        std::cout << "time " << elapsed_time << "ms: " << message << " " << get_queue_status() << std::endl;
+    // records an event stamped with the current time, along with the ready queue as it stands
+    EventRecord& log_event(EventKind kind, int p = -1, int a = 0, int b = 0) {
+        return log.record(elapsed_time, kind, p, a, b, q.begin(), q.end());
     }
-    // Define the comparison function
-    static bool compare_by_arrival_time(const Process& a, const Process& b) {
-        return a.arrival_time < b.arrival_time;
+    // bursts the process still has left, counting the current one
+    int bursts_left(int p) const {
+        return workload.num_bursts(p) - state[p].cursor;
+    }
+    // the process's current burst, 0 once it has none left
+    int front_burst(int p) const {
+        return bursts_left(p) > 0 ? workload.burst(p, state[p].cursor) : 0;
     }
-
 };
 
 #endif // OPSYSPROJ_FCFS_H
@@ -0,0 +1,224 @@
+#include "fcfs_fast.h"
+#include "steady_state.h"
+#include "run_budget.h"
+#include <vector>
+
+namespace {
+
+// how many dispatches ahead the next burst is prefetched
+const int PREFETCH_BURST = 16;
+
+// one process waiting for the CPU or for its I/O to complete, everything the sweep needs of it
+struct Entry {
+    sim_time t;  // when it joins (or joined) the ready queue
+    int next;    // index of its next burst in the workload's burst pool
+    int left;    // bursts left, negative for CPU-bound processes
+};
+
+// the order the simulator queues processes in: by time, then by handle, which the burst pool
+// is laid out in, so comparing pool indices compares handles
+inline bool later(const Entry& a, const Entry& b) {
+    return a.t != b.t ? a.t > b.t : a.next > b.next;
+}
+
+/*
+ * The sweep: every process not on the CPU, in the order it joins the ready queue.
+ *
+ * [head, ready_end) is the ready queue and [ready_end, tail) the I/O completions still to
+ * come. A completion is always later than anything already queued, so it is inserted from
+ * the tail, past the few completions still pending, and the whole sequence stays sorted:
+ * joining the queue is moving ready_end forward, and the CPU takes its bursts from head.
+ */
+class Sweep {
+public:
+    explicit Sweep(int n) : head(0), ready_end(0), tail(0) {
+        size_t size = 1;
+        while (size < (size_t) n) {
+            size <<= 1;
+        }
+        mask = (unsigned) size - 1;
+        entries.resize(size);
+    }
+
+    bool ready() const { return head != ready_end; }
+    bool pending() const { return ready_end != tail; }
+    bool empty() const { return head == tail; }
+    // first process in the ready queue, and the next I/O completion
+    const Entry& first() const { return entries[head & mask]; }
+    const Entry& next_completion() const { return entries[ready_end & mask]; }
+    // the burst the process PREFETCH_BURST places behind the first will run
+    const Entry& ahead() const { return entries[(head + PREFETCH_BURST) & mask]; }
+
+    Entry dispatch() { return entries[head++ & mask]; }
+    void complete_io() { ready_end++; }
+
+    // an arrival joins the queue at once, in front of any pending completion
+    void arrive(const Entry& e) {
+        for (unsigned pos = tail; pos != ready_end; --pos) {
+            entries[pos & mask] = entries[(pos - 1) & mask];
+        }
+        entries[ready_end & mask] = e;
+        ready_end++;
+        tail++;
+    }
+
+    // a process blocks on I/O, completing it later than anyone queued
+    void block(const Entry& e) {
+        unsigned pos = tail++;
+        while (pos != head && later(entries[(pos - 1) & mask], e)) {
+            entries[pos & mask] = entries[(pos - 1) & mask];
+            pos--;
+        }
+        entries[pos & mask] = e;
+    }
+
+    // the CPU ran through the queue without moving ready_end: everything left is an I/O
+    // completion it has not reached yet
+    void drained() { ready_end = head; }
+
+private:
+    std::vector<Entry> entries;  // a ring, every process is in at most one place so n slots do
+    unsigned mask;
+    unsigned head, ready_end, tail;
+};
+
+}
+
+SimStats fcfs_fast_statistics(const Workload& workload, int context_switch_time, SteadyStateProbe* probe,
+                              RunBudget* budget) {
+    const int n = workload.size();
+    const int half_switch = context_switch_time / 2;
+    const int* pool = workload.burst_pool();
+    Sweep sweep(n);
+
+    sim_time elapsed_time = 0;
+    bool cpu_free = true;
+    int i = 0;
+    Entry using_cpu = Entry();
+    sim_time time_cpu_frees = -1;
+    int processes_killed = 0;
+
+    // indexed by is_cpu_bound, so the bookkeeping has no per-class branches
+    long long wait[2] = {0, 0}, turnaround[2] = {0, 0};
+    int switches[2] = {0, 0};
+    long long total_cpu_time = 0;
+
+    while (processes_killed < n) {
+        if (budget != nullptr && budget->spent()) {
+            break;  // out of time, the caller throws the statistics away
+        }
+        if (i == n && cpu_free && sweep.ready()) {
+            // everyone has arrived and someone is waiting: until the queue runs dry each burst
+            // starts a full switch after the last one ends, and I/O that completes during a
+            // burst joins the queue before it ends, so one pass per burst does everything
+            sim_time frees;
+            do {
+                __builtin_prefetch(&pool[sweep.ahead().next]);
+                Entry c = sweep.dispatch();
+                int cls = c.left < 0 ? 1 : 0;
+                sim_time waited = elapsed_time - c.t;
+                wait[cls] += waited;
+                int burst = pool[c.next++];
+                c.left += cls ? 1 : -1;
+                frees = elapsed_time + half_switch + burst;
+                turnaround[cls] += burst + context_switch_time;
+                total_cpu_time += burst;
+                switches[cls]++;
+                if (probe != nullptr) {
+                    probe->wait.add(waited);
+                    probe->turnaround.add(waited + burst + context_switch_time);
+                }
+                if (c.left == 0) {
+                    processes_killed++;
+                } else {
+                    int io_burst = pool[c.next++];
+                    c.left += cls ? 1 : -1;
+                    c.t = frees + io_burst + half_switch;
+                    sweep.block(c);
+                }
+                elapsed_time = frees + half_switch;
+                // the next burst only starts if its process was queued before this one ended
+            } while (processes_killed < n && !sweep.empty() && sweep.first().t < frees &&
+                     (budget == nullptr || !budget->spent()));
+            sweep.drained();
+            continue;
+        }
+
+        // otherwise one event at a time, making exactly the decisions fcfs::run() makes
+        bool did_something = false;
+        sim_time io_next = sweep.pending() ? sweep.next_completion().t : -1;
+
+        if (i < n) {
+            int arrival = workload.arrival_time(i);
+            if ((time_cpu_frees == -1 || arrival <= time_cpu_frees) && (io_next == -1 || arrival <= io_next)) {
+                Entry e;
+                e.t = arrival;
+                e.next = workload.first_burst(i);
+                e.left = workload.is_cpu_bound(i) ? -workload.num_bursts(i) : workload.num_bursts(i);
+                sweep.arrive(e);
+                elapsed_time = arrival;
+                i++;
+                did_something = true;
+            }
+        }
+
+        if (cpu_free && sweep.ready()) {
+            cpu_free = false;
+            using_cpu = sweep.dispatch();
+            Entry& c = using_cpu;
+            int cls = c.left < 0 ? 1 : 0;
+            sim_time waited = elapsed_time - c.t;
+            wait[cls] += waited;
+            elapsed_time += half_switch;
+
+            int burst = pool[c.next++];
+            c.left += cls ? 1 : -1;
+            time_cpu_frees = burst + elapsed_time;
+            turnaround[cls] += burst + context_switch_time;
+            total_cpu_time += burst;
+            switches[cls]++;
+            if (probe != nullptr) {
+                probe->wait.add(waited);
+                // the block above keeps the simulator's burst + t_cs, the series includes the wait
+                probe->turnaround.add(waited + burst + context_switch_time);
+            }
+            did_something = true;
+        }
+
+        if (!did_something || time_cpu_frees == elapsed_time || io_next == elapsed_time) {
+            if (time_cpu_frees > 0 && (io_next == -1 || time_cpu_frees <= io_next)) {
+                elapsed_time = time_cpu_frees;
+                time_cpu_frees = -1;
+                cpu_free = true;
+                Entry& c = using_cpu;
+                if (c.left == 0) {
+                    processes_killed++;
+                } else {
+                    int io_burst = pool[c.next++];
+                    c.left += c.left < 0 ? 1 : -1;
+                    c.t = elapsed_time + io_burst + half_switch;
+                    sweep.block(c);
+                }
+                elapsed_time += half_switch;
+            } else if (io_next != -1 && (time_cpu_frees >= io_next || time_cpu_frees == -1)) {
+                sweep.complete_io();
+                elapsed_time = io_next;
+            } else if (!did_something) {
+                break;  // nothing left that can happen; the simulator would spin here forever
+            }
+        }
+    }
+
+    SimStats stats;
+    const double switches_total = (double) switches[0] + switches[1];
+    stats.cpu_util = (double) total_cpu_time / elapsed_time;
+    stats.cpu_turn = (double) turnaround[1] / switches[1];
+    stats.io_turn = (double) turnaround[0] / switches[0];
+    stats.tot_turn = ((double) turnaround[1] + turnaround[0]) / switches_total;
+    stats.cpu_wait = (double) wait[1] / switches[1];
+    stats.io_wait = (double) wait[0] / switches[0];
+    stats.tot_wait = ((double) wait[1] + wait[0]) / switches_total;
+    stats.num_cpu_switches = switches[1];
+    stats.num_io_switches = switches[0];
+    return stats;
+}
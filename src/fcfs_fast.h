@@ -0,0 +1,25 @@
+#ifndef OPSYSPROJ_FCFS_FAST_H
+#define OPSYSPROJ_FCFS_FAST_H
+
+#include "workload.h"
+#include "sim_stats.h"
+
+struct SteadyStateProbe;
+class RunBudget;
+
+/*
+ * FCFS statistics without running the traced simulator.
+ *
+ * Makes exactly the decisions fcfs::run() makes (so the numbers match it to the last digit)
+ * in a single sweep over the processes in the order they join the ready queue: one sorted
+ * ring holds the queue followed by the few I/O completions still to come, and once every
+ * process has arrived each CPU burst is one pass of a tight loop until the queue runs dry.
+ * Nothing is logged and nothing is allocated inside the loop.
+ * If probe is given, every dispatch also feeds it that burst's wait and turnaround, the latter
+ * from entering the ready queue to the end of the switch out (wait + burst + t_cs).
+ * If budget is given, the sweep stops once it is spent (see run_budget.h).
+ */
+SimStats fcfs_fast_statistics(const Workload& workload, int context_switch_time, SteadyStateProbe* probe = nullptr,
+                              RunBudget* budget = nullptr);
+
+#endif //OPSYSPROJ_FCFS_FAST_H
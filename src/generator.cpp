@@ -0,0 +1,78 @@
+#include "generator.h"
+#include <cmath>
+
+double next_exp(RandomGenerator& rng, double lambda, int bound, bool one_draw) {
+    if (one_draw) {
+        // u runs from bound down to 0 as it goes from 0 to 1, like -log(u) / lambda does
+        double tail = std::exp(-lambda * bound);
+        return -std::log(tail + rng.drand48() * (1 - tail)) / lambda;
+    }
+    // generates a random number from an exponential distribution with rate parameter lambda
+    // also uses the bound to make sure the returned value is valid
+    double value;
+    do {
+        value = -std::log(rng.drand48()) / lambda;
+    } while (value > bound);
+    return value;
+}
+
+/*
+ * generates a vector of processes based off of the parameters given in the command line args
+ */
+std::vector<Process> generate_processes(RandomGenerator& rng, int n, int ncpu, double lambda, int bound,
+                                        bool fixed_draws) {
+    std::vector<Process> processes;
+    processes.reserve(n);
+    char process_id[3] = "A0"; // init pid
+
+    // iterates through the # of processes
+    for (int i = 0; i < n; ++i) {
+        Process p; // initialize process
+        p.id = process_id;
+        p.arrival_time = std::floor(next_exp(rng, lambda, bound, fixed_draws));
+        p.is_cpu_bound = false;
+
+        int cpu_bursts_count = std::ceil(rng.drand48() * 32);
+        // with fixed draws every process draws all 32 CPU bursts, and keeps the first count
+        int cpu_bursts_drawn = fixed_draws ? 32 : cpu_bursts_count;
+        // iterates by # of cpu bursts
+        for (int j = 0; j < cpu_bursts_drawn; ++j) {
+            int cpu_burst = std::ceil(next_exp(rng, lambda, bound, fixed_draws));
+
+            // if cpu bound
+            if ( i < ncpu ) {
+                cpu_burst *= 4; // as per doc
+                p.is_cpu_bound = true;
+            }
+
+            if (j < cpu_bursts_count) {
+                p.bursts.push_back(cpu_burst);
+            }
+
+            // adds an io burst for the cpu burst if it's not the last
+            if (j < cpu_bursts_drawn - 1) {
+                int io_burst = std::ceil(next_exp(rng, lambda, bound, fixed_draws));
+
+                if (!p.is_cpu_bound) {
+                    // multiplies by 8 if it's an io burst bc those take longer
+                    io_burst *= 8;
+                }
+                if (j < cpu_bursts_count - 1) {
+                    p.bursts.push_back(io_burst);
+                }
+            }
+        }
+
+        processes.push_back(p);
+
+        // Increment process ID
+        if (process_id[1] == '9') {
+            process_id[1] = '0';
+            process_id[0]++;
+        } else {
+            process_id[1]++;
+        }
+    }
+
+    return processes;
+}
@@ -0,0 +1,26 @@
+#ifndef OPSYSPROJ_GENERATOR_H
+#define OPSYSPROJ_GENERATOR_H
+
+#include <vector>
+#include "rng.h"
+#include "process.h"
+
+/*
+ * draws from an exponential distribution with rate lambda, redrawing anything above bound;
+ * with one_draw, inverts the distribution truncated at bound instead, which gives the same
+ * distribution from exactly one u, decreasing in u as the redrawn one is
+ */
+double next_exp(RandomGenerator& rng, double lambda, int bound, bool one_draw = false);
+
+/*
+ * generates a vector of processes based off of the parameters given in the command line args,
+ * the first ncpu of them CPU-bound; the same rng state always gives the same process set.
+ * With fixed_draws every process takes the same number of u: each exponential is drawn with
+ * one_draw, and all 32 CPU bursts (and 31 I/O bursts) are drawn whatever the count, the ones
+ * past it dropped. The plain and antithetic streams of a seed then give processes that are
+ * paired burst for burst, but not the process set fixed_draws false gives.
+ */
+std::vector<Process> generate_processes(RandomGenerator& rng, int n, int ncpu, double lambda, int bound,
+                                        bool fixed_draws = false);
+
+#endif //OPSYSPROJ_GENERATOR_H
@@ -0,0 +1,30 @@
+#ifndef OPSYSPROJ_HASH_H
+#define OPSYSPROJ_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a, chained: pass the previous result as h to hash several fields as one
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t h = FNV_OFFSET) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ bytes[i]) * FNV_PRIME;
+    }
+    return h;
+}
+
+template <class T>
+inline uint64_t fnv1a_value(const T& value, uint64_t h = FNV_OFFSET) {
+    return fnv1a(&value, sizeof(value), h);
+}
+
+// the terminating '\0' goes in too, so "ab" + "c" and "a" + "bc" hash differently
+inline uint64_t fnv1a_string(const std::string& s, uint64_t h = FNV_OFFSET) {
+    return fnv1a(s.c_str(), s.size() + 1, h);
+}
+
+#endif //OPSYSPROJ_HASH_H
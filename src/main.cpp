@@ -16,21 +16,78 @@
 #include <iomanip>
 #include <fstream>
 #include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include "rng.h"
 #include "process.h"
+#include "workload.h"
+#include "generator.h"
 #include "fcfs.h"
+#include "fcfs_fast.h"
 #include "sjf.h"
 #include "srt.h"
 #include "rr.h"
+#include "prio.h"
+#include "replication.h"
+#include "steady_state.h"
+#include "result_cache.h"
+#include "simulate.h"
+#include "output_sink.h"
+#include "chrome_trace.h"
+#include "timeline.h"
+#include "shard.h"
+#include "server.h"
+#include "perf_counters.h"
+
+
+// optional flags that may follow the 8 positional arguments
+struct RunOptions {
+    bool run_o1; // --o1, also simulate the O(1) priority-array scheduler
+    TraceLevel trace; // --trace=off|cutoff|full, how much of each run is traced
+    bool trace_given;
+    // trace selection, see TraceFilter; process IDs are resolved once the workload exists
+    std::vector<std::pair<sim_time, sim_time> > trace_windows; // --trace-window=FROM:TO, repeatable
+    std::vector<std::string> trace_pids;              // --trace-pid=A0,B1,...
+    std::vector<EventKind> trace_kinds;               // --trace-kind=arrival,preempt,...
+    std::vector<int> rr_slices; // --rr-slices=16,32,..., extra RR time slices to sweep
+    int replications; // --replicate=R, compare the schedulers over R seeds instead of one run
+    bool antithetic;  // --antithetic, pair every replication with its 1 - u replica
+    double target_width; // --target-width=W, stop replicating once every interval is this narrow, 0 if not given
+    int threads;         // --threads=N, replications run at once by --target-width
+    bool steady_state;   // --steady-state, also estimate FCFS past its warm-up from this one run
+    std::string cache_dir; // --cache=DIR, result cache consulted when nothing is traced, empty if not given
+    std::string output;    // --output=text|binary|chrome|timeline|none, where traces and statistics go
+    ShardSpec shard;       // --shard=i/k, run only shard i of k of the --replicate study; count 0 if not given
+    bool perf;             // --perf, write the engines' counters and the time per phase to simout.perf.json
+
+    RunOptions() : run_o1(false), trace(TRACE_CUTOFF), trace_given(false), replications(0), antithetic(false),
+                   target_width(0), threads(0), steady_state(false), output("text"), perf(false) {
+        shard.index = 0;
+        shard.count = 0;
+    }
 
-
-// Functor to check if a process is CPU-bound
-struct IsCpuBound {
-    bool operator()(const Process& p) const {
-        return p.is_cpu_bound;
+    bool has_trace_filter() const {
+        return !trace_windows.empty() || !trace_pids.empty() || !trace_kinds.empty();
     }
 };
 
+// splits a comma separated list, skipping empty entries
+void split_list(const std::string& list, std::vector<std::string>& out) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        if (comma > start) {
+            out.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+}
+
 /*
  * In charge of parsing arguments via reference arguments
  *
@@ -55,11 +112,48 @@ struct IsCpuBound {
  *  *(argv + 7) -> alpha, exponential averaging const
  *
  *  *(argv + 8) -> slice_time, for Round Robin alg
+ *
+ *  anything after that is an optional flag stored in opts:
+ *      --o1 -> also run the O(1) priority-array scheduler after RR
+ *      --trace=off|cutoff|full -> trace nothing, the usual first 9999ms, or the whole run;
+ *                                 with off, FCFS statistics come from fcfs_fast_statistics()
+ *      --trace-window=FROM:TO -> only trace events in [FROM, TO] ms, may be given several times;
+ *                                implies --trace=full unless --trace is given too
+ *      --trace-pid=A0,B1 -> only trace events about these processes
+ *      --trace-kind=arrival,preempt -> only trace these kinds of event (see event_log.cpp)
+ *      --rr-slices=16,32,64 -> also append untraced RR statistics for each of these time slices
+ *      --replicate=R -> instead of the usual output, run every scheduler on the workloads of seeds
+ *                       seed .. seed + R - 1 and print paired confidence intervals (see replication.h)
+ *      --antithetic -> with --replicate, also run each seed's antithetic workload; both of a seed's
+ *                      workloads then take a fixed number of draws per process, so they pair up
+ *                      burst for burst (see generate_processes())
+ *      --target-width=0.05 -> with --replicate, stop once every confidence interval's half-width is
+ *                             at most this fraction of its mean; R becomes the replication budget
+ *      --threads=N -> replications run in parallel by --target-width, defaults to the core count
+ *      --steady-state -> after the FCFS block, append its wait and turnaround with the warm-up
+ *                        dropped and batch-means confidence intervals (see steady_state.h)
+ *      --cache=DIR -> with --trace=off, take statistics blocks (the --rr-slices ones too) from the
+ *                     result cache in DIR when an earlier run stored them, and store the rest
+ *      --output=text|binary|chrome|timeline|none -> traces to stdout and statistics to simout.txt (the
+ *                                                   default), everything as binary records in simout.bin,
+ *                                                   the traces as a Chrome trace-event timeline in
+ *                                                   simout.json or as indexed intervals in simout.timeline
+ *                                                   for "MAIN timeline FILE TIME|ID" to query (both imply
+ *                                                   --trace=full unless --trace is given), or nothing at all;
+ *                                                   only text prints anything to stdout, the Part I listing
+ *                                                   and Part II header included
+ *      --shard=i/k -> with --replicate, run only replications r with r % k == i and write them to
+ *                     shard-i-of-k.part instead of printing a report; "MAIN merge FILE..." combines
+ *                     the k files into the report (see shard.h)
+ *      --perf -> count what every simulated run's event loop does (events by kind, ready and I/O queue
+ *                traffic and depth, preemptions, arena allocations) and time each phase of the run,
+ *                written as JSON to simout.perf.json (see perf_counters.h); runs the --cache supplies
+ *                are not simulated and so not listed
  */
 void parse_arguments(int argc, char** argv, int &n, int &ncpu, int &seed, double &lambda, int &bound,
-                     int &context_time, double &alpha, int &slice_time) {
+                     int &context_time, double &alpha, int &slice_time, RunOptions &opts) {
     // error checking
-    if (argc != 9) {
+    if (argc < 9) {
         std::cerr << "ERROR: Incorrect number of arguments " << argc << std::endl;
         std::exit(1);
     }
@@ -87,6 +181,164 @@ void parse_arguments(int argc, char** argv, int &n, int &ncpu, int &seed, double
         std::cerr << "ERROR: Invalid argument type" << std::endl;
         std::exit(1);
     }
+
+    for (int a = 9; a < argc; ++a) {
+        std::string flag = argv[a];
+        if (flag == "--o1") {
+            opts.run_o1 = true;
+        } else if (flag == "--trace=off") {
+            opts.trace = TRACE_OFF;
+            opts.trace_given = true;
+        } else if (flag == "--trace=cutoff") {
+            opts.trace = TRACE_CUTOFF;
+            opts.trace_given = true;
+        } else if (flag == "--trace=full") {
+            opts.trace = TRACE_FULL;
+            opts.trace_given = true;
+        } else if (flag.compare(0, 15, "--trace-window=") == 0) {
+            std::string range = flag.substr(15);
+            size_t colon = range.find(':');
+            try {
+                if (colon == std::string::npos) {
+                    throw std::invalid_argument(range);
+                }
+                opts.trace_windows.push_back(std::make_pair(std::stoll(range.substr(0, colon)),
+                                                            std::stoll(range.substr(colon + 1))));
+            } catch (std::exception &e) {
+                std::cerr << "ERROR: Invalid trace window " << range << std::endl;
+                std::exit(1);
+            }
+        } else if (flag.compare(0, 12, "--trace-pid=") == 0) {
+            split_list(flag.substr(12), opts.trace_pids);
+        } else if (flag.compare(0, 13, "--trace-kind=") == 0) {
+            std::vector<std::string> names;
+            split_list(flag.substr(13), names);
+            for (size_t k = 0; k < names.size(); ++k) {
+                EventKind kind;
+                if (!parse_event_kind(names[k], kind)) {
+                    std::cerr << "ERROR: Unknown event kind " << names[k] << std::endl;
+                    std::exit(1);
+                }
+                opts.trace_kinds.push_back(kind);
+            }
+        } else if (flag.compare(0, 12, "--replicate=") == 0) {
+            try {
+                opts.replications = std::stoi(flag.substr(12));
+            } catch (std::exception &e) {
+                opts.replications = 0;
+            }
+            if (opts.replications < 2) {
+                std::cerr << "Incorrect Usage: --replicate needs at least 2 replications" << std::endl;
+                std::exit(1);
+            }
+        } else if (flag == "--antithetic") {
+            opts.antithetic = true;
+        } else if (flag == "--steady-state") {
+            opts.steady_state = true;
+        } else if (flag == "--perf") {
+            opts.perf = true;
+        } else if (flag.compare(0, 8, "--cache=") == 0 && flag.size() > 8) {
+            opts.cache_dir = flag.substr(8);
+        } else if (flag.compare(0, 8, "--shard=") == 0) {
+            if (!parse_shard(flag.substr(8), opts.shard)) {
+                std::cerr << "Incorrect Usage: --shard must be i/k with 0 <= i < k" << std::endl;
+                std::exit(1);
+            }
+        } else if (flag.compare(0, 9, "--output=") == 0) {
+            opts.output = flag.substr(9);
+            if (opts.output != "text" && opts.output != "binary" && opts.output != "chrome" && opts.output != "timeline" &&
+                opts.output != "none") {
+                std::cerr << "Incorrect Usage: --output must be text, binary, chrome, timeline or none" << std::endl;
+                std::exit(1);
+            }
+        } else if (flag.compare(0, 15, "--target-width=") == 0) {
+            try {
+                opts.target_width = std::stod(flag.substr(15));
+            } catch (std::exception &e) {
+                opts.target_width = 0;
+            }
+            if (opts.target_width <= 0) {
+                std::cerr << "Incorrect Usage: --target-width must be positive" << std::endl;
+                std::exit(1);
+            }
+        } else if (flag.compare(0, 10, "--threads=") == 0) {
+            try {
+                opts.threads = std::stoi(flag.substr(10));
+            } catch (std::exception &e) {
+                opts.threads = 0;
+            }
+            if (opts.threads <= 0) {
+                std::cerr << "Incorrect Usage: --threads must be positive" << std::endl;
+                std::exit(1);
+            }
+        } else if (flag.compare(0, 12, "--rr-slices=") == 0) {
+            std::vector<std::string> values;
+            split_list(flag.substr(12), values);
+            for (size_t v = 0; v < values.size(); ++v) {
+                int slice = 0;
+                try {
+                    slice = std::stoi(values[v]);
+                } catch (std::exception &e) {
+                }
+                if (slice <= 0) {
+                    std::cerr << "Incorrect Usage: slice time must be positive" << std::endl;
+                    std::exit(1);
+                }
+                opts.rr_slices.push_back(slice);
+            }
+        } else {
+            std::cerr << "ERROR: Unknown option " << flag << std::endl;
+            std::exit(1);
+        }
+    }
+    if (opts.target_width > 0 && opts.replications == 0) {
+        std::cerr << "Incorrect Usage: --target-width needs --replicate=R for its budget" << std::endl;
+        std::exit(1);
+    }
+    if (opts.shard.count > 0 && (opts.replications == 0 || opts.target_width > 0)) {
+        // an adaptive study decides what to run from results the other shards have
+        std::cerr << "Incorrect Usage: --shard needs --replicate=R and cannot be combined with --target-width"
+                  << std::endl;
+        std::exit(1);
+    }
+    // asking for a window past the usual cutoff should not need --trace=full as well
+    if (!opts.trace_windows.empty() && !opts.trace_given) {
+        opts.trace = TRACE_FULL;
+    }
+    // a timeline that stops at the cutoff would show every burst still running then as never ending;
+    // chrome output takes the log a chunk at a time, timeline holds it in memory for the length
+    // of each run, which --trace-window keeps smaller
+    if ((opts.output == "chrome" || opts.output == "timeline") && !opts.trace_given) {
+        opts.trace = TRACE_FULL;
+    }
+}
+
+/*
+ * Builds the TraceFilter asked for on the command line, resolving process IDs to handles
+ *
+ * ARGUMENTS:
+ *  workload -> the process set every scheduler runs
+ *  opts -> parsed command line flags
+ *  filter -> filled in here
+ */
+void build_trace_filter(const Workload& workload, const RunOptions& opts, TraceFilter& filter) {
+    for (size_t w = 0; w < opts.trace_windows.size(); ++w) {
+        filter.add_window(opts.trace_windows[w].first, opts.trace_windows[w].second);
+    }
+    for (size_t k = 0; k < opts.trace_kinds.size(); ++k) {
+        filter.add_kind(opts.trace_kinds[k]);
+    }
+    for (size_t p = 0; p < opts.trace_pids.size(); ++p) {
+        int h = 0;
+        while (h < workload.size() && workload.id(h) != opts.trace_pids[p]) {
+            h++;
+        }
+        if (h == workload.size()) {
+            std::cerr << "ERROR: Unknown process " << opts.trace_pids[p] << std::endl;
+            std::exit(1);
+        }
+        filter.add_process(h, workload.size());
+    }
 }
 
 //functions for pseudo random number generator
@@ -101,69 +353,6 @@ void parse_arguments(int argc, char** argv, int &n, int &ncpu, int &seed, double
 //    std::srand(seed);
 //}
 //
-double next_exp(RandomGenerator& rng, double lambda, int bound) {
-    // generates a random number from an exponential distribution with rate parameter lambda
-    // also uses the bound to make sure the returned value is valid
-    double value;
-    do {
-        value = -std::log(rng.drand48()) / lambda;
-    } while (value > bound);
-    return value;
-}
-
-/*
- * generates a vector of processes based off of the parameters given in the command line args
- */
-std::vector<Process> generate_processes(RandomGenerator& rng, int n, int ncpu, double lambda, int bound) {
-    std::vector<Process> processes;
-    char process_id[3] = "A0"; // init pid
-
-    // iterates through the # of processes
-    for (int i = 0; i < n; ++i) {
-        Process p; // initialize process
-        p.id = process_id;
-        p.arrival_time = std::floor(next_exp(rng, lambda, bound));
-        p.is_cpu_bound = false;
-
-        int cpu_bursts_count = std::ceil(rng.drand48() * 32);
-        // iterates by # of cpu bursts
-        for (int j = 0; j < cpu_bursts_count; ++j) {
-            int cpu_burst = std::ceil(next_exp(rng, lambda, bound));
-
-            // if cpu bound
-            if ( i < ncpu ) {
-                cpu_burst *= 4; // as per doc
-                p.is_cpu_bound = true;
-            }
-
-            p.bursts.push_back(cpu_burst);
-
-            // adds an io burst for the cpu burst if it's not the last
-            if (j < cpu_bursts_count - 1) {
-                int io_burst = std::ceil(next_exp(rng, lambda, bound));
-
-                if (!p.is_cpu_bound) {
-                    // multiplies by 8 if it's an io burst bc those take longer
-                    io_burst *= 8;
-                }
-                p.bursts.push_back(io_burst);
-            }
-        }
-
-        processes.push_back(p);
-
-        // Increment process ID
-        if (process_id[1] == '9') {
-            process_id[1] = '0';
-            process_id[0]++;
-        } else {
-            process_id[1]++;
-        }
-    }
-
-    return processes;
-}
-
 /*
  * manages the output to stdout of our random processes
  *
@@ -175,71 +364,53 @@ std::vector<Process> generate_processes(RandomGenerator& rng, int n, int ncpu, d
  *      lambda -> (1/lambda) represents the average number for
  *                the random number generator
  *      bound -> upper bound for rnums
+ *      sink -> gets the listing as console text
  */
-void part1_print(const std::vector<Process>& processes, int n, int ncpu, int seed, double lambda, int bound) {
-    std::cout << "<<< PROJECT PART I" << std::endl;
-    std::cout << "<<< -- process set (n=" << n << ") with " << ncpu << " CPU-bound process" <<
+void part1_print(const std::vector<Process>& processes, int n, int ncpu, int seed, double lambda, int bound,
+                 OutputSink& sink) {
+    std::ostringstream out;
+    out << "<<< PROJECT PART I" << std::endl;
+    out << "<<< -- process set (n=" << n << ") with " << ncpu << " CPU-bound process" <<
               (ncpu > 1 ? "es" : "") << std::endl;
-    std::cout << "<<< -- seed=" << seed << "; lambda=" << std::fixed << std::setprecision(6) <<
+    out << "<<< -- seed=" << seed << "; lambda=" << std::fixed << std::setprecision(6) <<
               lambda << "; bound=" << bound << std::endl;
 
     // loops through our processes
     for (int j = 0 ; j < n ; j++) {
         const Process & p = processes[j];
         bool is_cpu_bound = p.is_cpu_bound;
-        std::cout << (is_cpu_bound ? "CPU-bound" : "I/O-bound") << " process " << p.id << ": arrival time " <<
+        out << (is_cpu_bound ? "CPU-bound" : "I/O-bound") << " process " << p.id << ": arrival time " <<
                   p.arrival_time << "ms; " << (p.bursts.size() / 2) + 1 << " CPU burst" <<
                   ((p.bursts.size() / 2) + 1 == 1 ? "" : "s") /* << ":"*/ << std::endl;
     }
+    sink.console(out.str());
 }
 
 
 
 /*
- * handles writing our outputs to filename based on described in the assignment
+ * handles writing our outputs to the sink based on described in the assignment
  *
  * ARGUMENTS:
- *      processes -> our generated processes
- *      filename -> name of the file to print to
+ *      workload -> our generated processes, with the burst totals gathered as it was built
+ *      sink -> where the statistics go, simout.txt unless --output says otherwise
  */
-void write_statistics(const std::vector<Process>& processes, const std::string& filename) {
-    int num_processes = processes.size();
-    int num_cpu_bound = std::count_if(processes.begin(), processes.end(), IsCpuBound());
-    int num_io_bound = num_processes - num_cpu_bound;
-
-    double total_cpu_bound_cpu_burst_time = 0;
-    double total_cpu_bound_io_burst_time = 0;
-    int total_cpu_bound_cpu_bursts = 0;
-    int total_cpu_bound_io_bursts = 0;
-
-    double total_io_bound_cpu_burst_time = 0;
-    double total_io_bound_io_burst_time = 0;
-    int total_io_bound_cpu_bursts = 0;
-    int total_io_bound_io_bursts = 0;
-
-    // loops through all processes
-    for (int j = 0 ; j < num_processes ; j++) {
-        const Process & p = processes[j];
-        bool is_cpu_bound = p.is_cpu_bound;
-        // loops through all bursts
-        for (size_t i = 0; i < p.bursts.size(); i += 2) {
-            if (is_cpu_bound) {
-                total_cpu_bound_cpu_burst_time += p.bursts[i];
-                total_cpu_bound_cpu_bursts++;
-                if (i + 1 < p.bursts.size()) {
-                    total_cpu_bound_io_burst_time += p.bursts[i + 1];
-                    total_cpu_bound_io_bursts++;
-                }
-            } else {
-                total_io_bound_cpu_burst_time += p.bursts[i];
-                total_io_bound_cpu_bursts++;
-                if (i + 1 < p.bursts.size()) {
-                    total_io_bound_io_burst_time += p.bursts[i + 1];
-                    total_io_bound_io_bursts++;
-                }
-            }
-        }
-    }
+void write_statistics(const Workload& workload, OutputSink& sink) {
+    const BurstSummary& cpu_bound = workload.summary(true);
+    const BurstSummary& io_bound = workload.summary(false);
+    int num_processes = workload.size();
+    int num_cpu_bound = cpu_bound.processes;
+    int num_io_bound = io_bound.processes;
+
+    double total_cpu_bound_cpu_burst_time = cpu_bound.cpu_time;
+    double total_cpu_bound_io_burst_time = cpu_bound.io_time;
+    int total_cpu_bound_cpu_bursts = cpu_bound.cpu_bursts;
+    int total_cpu_bound_io_bursts = cpu_bound.io_bursts;
+
+    double total_io_bound_cpu_burst_time = io_bound.cpu_time;
+    double total_io_bound_io_burst_time = io_bound.io_time;
+    int total_io_bound_cpu_bursts = io_bound.cpu_bursts;
+    int total_io_bound_io_bursts = io_bound.io_bursts;
 
     double avg_cpu_bound_cpu_burst_time = total_cpu_bound_cpu_bursts > 0 ?
                                           std::ceil((total_cpu_bound_cpu_burst_time / total_cpu_bound_cpu_bursts) * 1000.0) / 1000.0 : 0;
@@ -258,7 +429,7 @@ void write_statistics(const std::vector<Process>& processes, const std::string&
                                                   (total_cpu_bound_io_bursts + total_io_bound_io_bursts)) * 1000.0) / 1000.0 : 0;
 
 
-    std::ofstream out(filename);
+    std::ostringstream out;
     out << "-- number of processes: " << num_processes << std::endl;
     out << "-- number of CPU-bound processes: " << num_cpu_bound << std::endl;
     out << "-- number of I/O-bound processes: " << num_io_bound << std::endl;
@@ -274,7 +445,47 @@ void write_statistics(const std::vector<Process>& processes, const std::string&
         avg_io_bound_io_burst_time << " ms" << std::endl;
     out << "-- overall average I/O burst time: " << std::fixed << std::setprecision(3) <<
         overall_avg_io_burst_time << " ms" << std::endl << std::endl;
-    out.close();
+    sink.text(out.str());
+}
+
+
+/*
+ * simulates policy and hands the run to sink; with a cache, the statistics block is taken
+ * from it when an earlier run stored it under key, and otherwise stored there for next time
+ *
+ * ARGUMENTS:
+ *      cache -> the result cache, nullptr to always simulate
+ *      key -> what the block is stored under, see ResultCache::key()
+ *      policy, workload, params -> the run, see simulate()
+ *      sink -> where the statistics (and, uncached, the trace) go
+ *      perf -> gets the counters of the run when it is simulated, nullptr to not count
+ */
+void simulate_cached(ResultCache* cache, uint64_t key, Policy policy, const Workload& workload,
+                     const SimParams& params, OutputSink& sink, PerfReport* perf) {
+    SimParams counted = params;
+    if (cache == nullptr) {
+        if (perf != nullptr) {
+            counted.counters = &perf->start_run(policy_name(policy));
+        }
+        simulate(workload, policy, counted, &sink);
+        return;
+    }
+    std::string block;
+    if (!cache->lookup(key, block)) {
+        if (perf != nullptr) {
+            counted.counters = &perf->start_run(policy_name(policy));
+        }
+        std::ostringstream out;
+        write_statistics_block(policy, simulate(workload, policy, counted), out);
+        block = out.str();
+        cache->store(key, block);
+    }
+    sink.text(block);
+}
+
+// what the --rr-slices block for slice is cached under
+uint64_t sweep_key(int slice, int t_cs, uint64_t workload_hash) {
+    return ResultCache::key("RR sweep", t_cs, 0, 0, slice, workload_hash);
 }
 
 
@@ -283,35 +494,98 @@ void write_statistics(const std::vector<Process>& processes, const std::string&
  *
  * ARGS:
  *
- * processes -> vector of processes
+ * workload -> the generated processes, shared read-only by every algorithm
  * t_cs -> context switch time
  * alpha -> alpha used for SRT and SJF
  * t_slc -> slice time
+ * opts -> optional flags, e.g. whether to run the O(1) scheduler too
+ * perf -> gets each simulated run's counters and the time of what has none, nullptr with no --perf
  */
-void part2_print(std::vector<Process> processes, int t_cs, double alpha, int t_slice, double lambda) {
-    std::cout << std::endl;
-    std::cout << "<<< PROJECT PART II\n<<< -- t_cs=" << t_cs << "ms; alpha=" << std::setprecision(2) <<
+void part2_print(const Workload& workload, int t_cs, double alpha, int t_slice, double lambda,
+                 const RunOptions &opts, OutputSink& sink, PerfReport* perf) {
+    // fixed, as Part I's lambda left stdout when it was printed there
+    std::ostringstream header;
+    header << std::endl;
+    header << "<<< PROJECT PART II\n<<< -- t_cs=" << t_cs << "ms; alpha=" << std::fixed << std::setprecision(2) <<
             alpha << "; t_slice=" << t_slice << "ms" << std::endl;
+    sink.console(header.str());
+
+    TraceFilter trace_filter;
+    build_trace_filter(workload, opts, trace_filter);
+    SimParams params;
+    params.t_cs = t_cs;
+    params.alpha = alpha;
+    params.lambda = lambda;
+    params.t_slice = t_slice;
+    params.trace = opts.trace;
+    params.filter = opts.has_trace_filter() ? &trace_filter : nullptr;
+
+    // with nothing to trace, statistics blocks an earlier run stored can stand in for simulating
+    std::unique_ptr<ResultCache> cache;
+    uint64_t workload_hash = 0;
+    if (opts.trace == TRACE_OFF && !opts.cache_dir.empty()) {
+        cache.reset(new ResultCache(opts.cache_dir));
+        workload_hash = workload.content_hash();
+    }
 
-    // here is where we call of the individual classes for our algorithms
-    fcfs FCFS(processes, t_cs);
-    std::cout << std::endl;
-    FCFS.write_statistics("simout.txt");
+    // here is where we call of the individual classes for our algorithms; with --trace=off
+    // FCFS statistics come from the fast path, which gives the same numbers without the simulator
+    simulate_cached(cache.get(), ResultCache::key("FCFS", t_cs, 0, 0, 0, workload_hash), POLICY_FCFS,
+                    workload, params, sink, perf);
+    sink.console("\n");
+    if (opts.steady_state) {
+        // the fast path makes the same decisions, so its per-burst series is the run's
+        SteadyStateProbe probe;
+        Stopwatch watch;
+        fcfs_fast_statistics(workload, t_cs, &probe);
+        if (perf != nullptr) {
+            perf->add_time(PHASE_SIMULATE, watch.lap());
+        }
+        std::ostringstream out;
+        write_steady_state(probe, "FCFS", out);
+        sink.text(out.str());
+    }
     ///ricky added this for sjf
-    sjf sjf_scheduler(processes, t_cs, alpha, lambda);
-    sjf_scheduler.simulate();
-    sjf_scheduler.write_statistics("simout.txt");
-    std::cout << std::endl;
-
-    srt SRT = srt(processes, t_cs, alpha, lambda);
-    SRT.simulate();
-//    SRT.simulate();
-    SRT.write_statistics("simout.txt");
-    std::cout << std::endl;
-
-    rr RR(processes, t_cs, t_slice);
-    RR.write_statistics("simout.txt");
+    simulate_cached(cache.get(), ResultCache::key("SJF", t_cs, alpha, lambda, 0, workload_hash), POLICY_SJF,
+                    workload, params, sink, perf);
+    sink.console("\n");
+
+    simulate_cached(cache.get(), ResultCache::key("SRT", t_cs, alpha, lambda, 0, workload_hash), POLICY_SRT,
+                    workload, params, sink, perf);
+    sink.console("\n");
+
+    simulate_cached(cache.get(), ResultCache::key("RR", t_cs, 0, 0, t_slice, workload_hash), POLICY_RR,
+                    workload, params, sink, perf);
+
+    // each extra slice is its own untraced RR run, unless the cache already has its block
+    for (size_t k = 0; k < opts.rr_slices.size(); ++k) {
+        const int slice = opts.rr_slices[k];
+        const std::string heading = "Algorithm RR (t_slice=" + std::to_string(slice) + "ms)";
+        std::string block;
+        if (cache && cache->lookup(sweep_key(slice, t_cs, workload_hash), block)) {
+            sink.text(block);
+            continue;
+        }
+        SimParams sweep = params;
+        sweep.t_slice = slice;
+        sweep.trace = TRACE_OFF;
+        sweep.filter = nullptr;
+        if (perf != nullptr) {
+            sweep.counters = &perf->start_run(heading);
+        }
+        SimStats stats = simulate(workload, POLICY_RR, sweep);
+        sink.statistics(POLICY_RR, stats, heading);
+        if (cache) {
+            std::ostringstream out;
+            write_statistics_block(POLICY_RR, stats, out, heading);
+            cache->store(sweep_key(slice, t_cs, workload_hash), out.str());
+        }
+    }
 
+    if (opts.run_o1) {
+        sink.console("\n");
+        simulate_cached(nullptr, 0, POLICY_PRIO, workload, params, sink, perf);
+    }
 
 }
 
@@ -319,15 +593,139 @@ void part2_print(std::vector<Process> processes, int t_cs, double alpha, int t_s
 int main(int argc, char** argv) {
     int n, ncpu, seed, bound, context_time, slice_time;
     double lambda, alpha;
+    RunOptions opts;
+
+    // MAIN serve SOCKET [--threads=N] answers simulate requests until killed (see server.h)
+    if (argc > 1 && std::string(argv[1]) == "serve") {
+        if (argc < 3) {
+            std::cerr << "ERROR: Incorrect Usage: MAIN serve SOCKET [--threads=N]" << std::endl;
+            return 1;
+        }
+        int threads = (int) std::thread::hardware_concurrency();
+        for (int i = 3; i < argc; ++i) {
+            std::string flag = argv[i];
+            if (flag.compare(0, 10, "--threads=") == 0 && std::atoi(flag.c_str() + 10) > 0) {
+                threads = std::atoi(flag.c_str() + 10);
+            } else {
+                std::cerr << "ERROR: Unknown option " << flag << std::endl;
+                return 1;
+            }
+        }
+        SimulationServer server(argv[2], threads);
+        std::string error;
+        if (!server.serve(error)) {
+            std::cerr << "ERROR: " << error << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // MAIN timeline FILE TIME|ID says who was running and queued at TIME, or lists ID's intervals
+    if (argc > 1 && std::string(argv[1]) == "timeline") {
+        if (argc != 4) {
+            std::cerr << "ERROR: Incorrect Usage: MAIN timeline FILE TIME|ID" << std::endl;
+            return 1;
+        }
+        try {
+            query_timelines(argv[2], argv[3], std::cout);
+        } catch (std::exception &e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    parse_arguments(argc, argv, n, ncpu, seed, lambda, bound, context_time, alpha, slice_time);
+    // MAIN merge FILE... reports a study from the files its shards wrote
+    if (argc > 1 && std::string(argv[1]) == "merge") {
+        try {
+            merge_shards(std::vector<std::string>(argv + 2, argv + argc), std::cout);
+        } catch (std::runtime_error &e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    parse_arguments(argc, argv, n, ncpu, seed, lambda, bound, context_time, alpha, slice_time, opts);
+    if (opts.replications > 0) {
+        ExperimentConfig config = {n, ncpu, lambda, bound, context_time, alpha, slice_time};
+        if (opts.shard.count > 0) {
+            try {
+                run_shard(config, seed, opts.replications, opts.antithetic, opts.shard, shard_filename(opts.shard));
+            } catch (std::runtime_error &e) {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+        ReplicationStudy study(config, seed, opts.antithetic);
+        if (opts.target_width > 0) {
+            int threads = opts.threads > 0 ? opts.threads : (int) std::thread::hardware_concurrency();
+            study.run_adaptive(opts.target_width, opts.replications, threads);
+        } else {
+            study.run(opts.replications);
+        }
+        study.write_report(std::cout);
+        return 0;
+    }
+    // with --perf each phase is timed, the report is written once everything else has been
+    std::unique_ptr<PerfReport> perf(opts.perf ? new PerfReport() : nullptr);
+    Stopwatch watch;
     RandomGenerator rng(seed);
 
     std::vector<Process> processes = generate_processes(rng, n, ncpu, lambda, bound);
+    const double generation_seconds = watch.lap();
+
+    // everything the simulations produce goes through one sink, opened once for the whole run
+    std::unique_ptr<OutputSink> sink;
+    if (opts.output == "none") {
+        sink.reset(new NullSink());
+    } else if (opts.output == "binary") {
+        sink.reset(new BinarySink("simout.bin"));
+    } else if (opts.output == "chrome") {
+        sink.reset(new ChromeTraceSink("simout.json", "simout.txt", context_time));
+    } else if (opts.output == "timeline") {
+        sink.reset(new TimelineSink("simout.txt", context_time));
+    } else {
+        sink.reset(new FileSink(std::cout, "simout.txt"));
+    }
+    if (!sink->is_open()) {
+        std::cerr << "ERROR: Could not create the output files for --output=" << opts.output << std::endl;
+        return 1;
+    }
 
-    part1_print(processes, n, ncpu, seed, lambda, bound);
-    write_statistics(processes, "simout.txt");
-    part2_print(processes, context_time, alpha, slice_time, lambda);
+    part1_print(processes, n, ncpu, seed, lambda, bound, *sink);
+    double output_seconds = watch.lap();
+    Workload workload(processes);
+    const double sort_seconds = watch.lap();
+    write_statistics(workload, *sink);
+    output_seconds += watch.lap();
+    // part II times its own runs, its output is part of them
+    part2_print(workload, context_time, alpha, slice_time, lambda, opts, *sink, perf.get());
+    watch.lap();
+    if (opts.output == "timeline") {
+        try {
+            static_cast<TimelineSink&>(*sink).write("simout.timeline");
+        } catch (std::runtime_error &e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    // closing the sink flushes what it buffered
+    sink.reset();
+    output_seconds += watch.lap();
+
+    if (perf) {
+        perf->add_time(PHASE_GENERATION, generation_seconds);
+        perf->add_time(PHASE_SORT, sort_seconds);
+        perf->add_time(PHASE_OUTPUT, output_seconds);
+        std::ofstream perf_file("simout.perf.json", std::ios::out | std::ios::trunc);
+        perf->write_json(perf_file);
+        if (!perf_file) {
+            std::cerr << "ERROR: Could not write simout.perf.json" << std::endl;
+            return 1;
+        }
+    }
 
 
 
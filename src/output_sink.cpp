@@ -0,0 +1,108 @@
+#include "output_sink.h"
+#include <cstdint>
+#include "fcfs.h"
+#include "sjf.h"
+#include "srt.h"
+#include "rr.h"
+#include "prio.h"
+
+void write_statistics_block(Policy policy, const SimStats& stats, std::ostream& out, const std::string& heading) {
+    switch (policy) {
+        case POLICY_FCFS:
+            fcfs::write_statistics(stats, out);
+            break;
+        case POLICY_SJF:
+            sjf::write_statistics(stats, out);
+            break;
+        case POLICY_SRT:
+            srt::write_statistics(stats, out);
+            break;
+        case POLICY_RR:
+            rr::write_statistics(stats, out, heading.empty() ? "Algorithm RR" : heading);
+            break;
+        case POLICY_PRIO:
+            prio::write_statistics(stats, out);
+            break;
+        default:
+            break;
+    }
+}
+
+void StreamSink::events(const Workload& workload, const EventLog& log) {
+    log.render(workload, *trace);
+}
+
+void StreamSink::statistics(Policy policy, const SimStats& stats, const std::string& heading) {
+    write_statistics_block(policy, stats, *this->stats, heading);
+}
+
+void StreamSink::text(const std::string& block) {
+    *stats << block;
+}
+
+void StreamSink::console(const std::string& text) {
+    if (trace != nullptr) {
+        *trace << text;
+    }
+}
+
+FileSink::FileSink(std::ostream& trace, const std::string& filename, size_t buffer_size) : buffer(buffer_size) {
+    // the buffer has to be in place before the file is opened for every library to use it
+    if (!buffer.empty()) {
+        file.rdbuf()->pubsetbuf(buffer.data(), (std::streamsize) buffer.size());
+    }
+    file.open(filename.c_str(), std::ios::out | std::ios::trunc);
+    this->trace = &trace;
+    stats = &file;
+}
+
+namespace {
+
+void append_int(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void append_string(std::string& out, const std::string& s) {
+    append_int(out, (uint32_t) s.size());
+    out += s;
+}
+
+}
+
+BinarySink::BinarySink(const std::string& filename)
+        : file(filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary) {
+    file.write("OSPSINK1", 8);
+}
+
+void BinarySink::record(int tag, const std::string& payload) {
+    const char t = (char) tag;
+    const uint32_t length = (uint32_t) payload.size();
+    file.write(&t, 1);
+    file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file.write(payload.data(), (std::streamsize) payload.size());
+}
+
+void BinarySink::events(const Workload&, const EventLog& log) {
+    std::string payload;
+    append_string(payload, log.name());
+    append_int(payload, (uint32_t) log.size());
+    for (size_t e = 0; e < log.size(); ++e) {
+        payload.append(reinterpret_cast<const char*>(&log[e]), sizeof(EventRecord));
+    }
+    const std::vector<int>& pool = log.queues();
+    append_int(payload, (uint32_t) pool.size());
+    payload.append(reinterpret_cast<const char*>(pool.data()), pool.size() * sizeof(int));
+    record(BIN_EVENTS, payload);
+}
+
+void BinarySink::statistics(Policy policy, const SimStats& stats, const std::string& heading) {
+    std::string payload;
+    append_int(payload, (uint32_t) policy);
+    append_string(payload, heading);
+    payload.append(reinterpret_cast<const char*>(&stats), sizeof(stats));
+    record(BIN_STATISTICS, payload);
+}
+
+void BinarySink::text(const std::string& block) {
+    record(BIN_TEXT, block);
+}
@@ -0,0 +1,132 @@
+#ifndef OPSYSPROJ_OUTPUT_SINK_H
+#define OPSYSPROJ_OUTPUT_SINK_H
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "policy.h"
+#include "sim_stats.h"
+#include "event_log.h"
+#include "workload.h"
+
+// writes the statistics block of policy to out; heading replaces "Algorithm RR" for RR when not empty
+void write_statistics_block(Policy policy, const SimStats& stats, std::ostream& out, const std::string& heading = "");
+
+/*
+ * Where everything a simulation produces goes: its trace, its statistics, any block that is
+ * already text (the workload summary, cached blocks, steady-state estimates), and the console
+ * text that frames a run on stdout (the Part I listing, the Part II header, the blank lines
+ * between algorithms).
+ *
+ * The schedulers never write anywhere themselves; simulate() hands each finished run to a
+ * sink, and whoever owns the sink decides whether that means a file, memory or nothing. Every
+ * call has a no-op default, so a sink only overrides what it keeps, and a sink that does not
+ * want_events() gets runs simulated with tracing compiled out.
+ */
+class OutputSink {
+public:
+    virtual ~OutputSink() {}
+
+    // false when a file the sink writes could not be created
+    virtual bool is_open() const { return true; }
+
+    // whether events() should be called at all, when not the run is not traced
+    virtual bool wants_events() const { return false; }
+    // a finished run's trace
+    virtual void events(const Workload& workload, const EventLog& log) {}
+    // a sink that can take a run's trace in chunks while it is recorded returns the drain to hand
+    // its log (see EventLog::set_drain()), called before the run starts; events() then only gets
+    // the last chunk. nullptr, the default, gets the whole trace in events()
+    virtual EventDrain* event_drain(const Workload& workload) { return nullptr; }
+    // one algorithm's statistics, heading as for write_statistics_block()
+    virtual void statistics(Policy policy, const SimStats& stats, const std::string& heading = "") {}
+    virtual void text(const std::string& block) {}
+    // text for the console, which the text output interleaves with the traces
+    virtual void console(const std::string& text) {}
+};
+
+// keeps nothing, for runs only the return value of simulate() matters for
+class NullSink : public OutputSink {
+};
+
+/*
+ * Renders traces to one stream and statistics blocks to another, as the project's output.
+ * Console text goes to the trace stream, or nowhere for subclasses without one. Either stream
+ * may be shared with other writers; the sink only appends.
+ */
+class StreamSink : public OutputSink {
+public:
+    StreamSink(std::ostream& trace, std::ostream& stats) : trace(&trace), stats(&stats) {}
+
+    bool wants_events() const { return true; }
+    void events(const Workload& workload, const EventLog& log);
+    void statistics(Policy policy, const SimStats& stats, const std::string& heading = "");
+    void text(const std::string& block);
+    void console(const std::string& text);
+
+protected:
+    // for subclasses that own their streams and point the sink at them once they exist
+    StreamSink() : trace(nullptr), stats(nullptr) {}
+    std::ostream* trace;
+    std::ostream* stats;
+};
+
+/*
+ * Text output with the statistics going to a file that is opened (and truncated) once for
+ * the whole run, behind a buffer of buffer_size bytes, instead of reopened for every block.
+ */
+class FileSink : public StreamSink {
+public:
+    FileSink(std::ostream& trace, const std::string& filename, size_t buffer_size = 1 << 16);
+
+    bool is_open() const { return file.is_open(); }
+
+private:
+    std::vector<char> buffer;
+    std::ofstream file;
+};
+
+// keeps the text in memory, for callers that want it as strings
+class MemorySink : public StreamSink {
+public:
+    MemorySink() { trace = &trace_text; stats = &stats_text; }
+
+    std::string trace_output() const { return trace_text.str(); }
+    std::string statistics_output() const { return stats_text.str(); }
+
+private:
+    std::ostringstream trace_text, stats_text;
+};
+
+/*
+ * Writes everything as binary records, for tools that want the numbers rather than text:
+ * after an 8 byte "OSPSINK1" header, each record is a one byte tag (BIN_EVENTS, BIN_STATISTICS
+ * or BIN_TEXT), a 4 byte payload length and the payload, all in host byte order.
+ *
+ *      events: algorithm name (4 byte length + bytes), 4 byte record count, the EventRecords
+ *              as they are in memory, 4 byte queue pool length, the pool's handles
+ *      statistics: 4 byte policy, heading (4 byte length + bytes), the SimStats as in memory
+ *      text: the bytes
+ */
+class BinarySink : public OutputSink {
+public:
+    enum { BIN_EVENTS = 1, BIN_STATISTICS = 2, BIN_TEXT = 3 };
+
+    explicit BinarySink(const std::string& filename);
+
+    bool is_open() const { return file.is_open(); }
+    bool wants_events() const { return true; }
+    void events(const Workload& workload, const EventLog& log);
+    void statistics(Policy policy, const SimStats& stats, const std::string& heading = "");
+    void text(const std::string& block);
+
+private:
+    std::ofstream file;
+
+    void record(int tag, const std::string& payload);
+};
+
+#endif //OPSYSPROJ_OUTPUT_SINK_H
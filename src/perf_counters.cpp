@@ -0,0 +1,67 @@
+#include "perf_counters.h"
+#include <iomanip>
+
+PerfCounters::PerfCounters()
+        : iterations(0), ready_pushes(0), ready_pops(0), max_ready_depth(0), io_pushes(0), max_io_depth(0),
+          preemptions(0), arena_requests(0), arena_fresh(0), arena_upstream(0), simulate_seconds(0),
+          output_seconds(0) {
+    for (int k = 0; k < NUM_EVENT_KINDS; ++k) {
+        events[k] = 0;
+    }
+}
+
+void PerfCounters::take_memory(const Arena& arena) {
+    arena_requests = arena.requests();
+    arena_fresh = arena.fresh_allocations();
+    arena_upstream = arena.upstream_allocations();
+}
+
+const char* phase_name(Phase phase) {
+    static const char* const names[NUM_PHASES] = {"generation", "sort", "simulate", "output"};
+    return names[phase];
+}
+
+PerfReport::PerfReport() {
+    for (int k = 0; k < NUM_PHASES; ++k) {
+        phase_seconds[k] = 0;
+    }
+}
+
+PerfCounters& PerfReport::start_run(const std::string& name) {
+    runs.push_back(std::make_pair(name, PerfCounters()));
+    return runs.back().second;
+}
+
+void PerfReport::write_json(std::ostream& out) const {
+    double seconds[NUM_PHASES];
+    for (int k = 0; k < NUM_PHASES; ++k) {
+        seconds[k] = phase_seconds[k];
+    }
+    for (size_t r = 0; r < runs.size(); ++r) {
+        seconds[PHASE_SIMULATE] += runs[r].second.simulate_seconds;
+        seconds[PHASE_OUTPUT] += runs[r].second.output_seconds;
+    }
+
+    out << std::fixed << std::setprecision(6);
+    out << "{\n  \"phases\": {";
+    for (int k = 0; k < NUM_PHASES; ++k) {
+        out << (k > 0 ? ", " : "") << "\"" << phase_name((Phase) k) << "\": " << seconds[k];
+    }
+    out << "},\n  \"runs\": [";
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const PerfCounters& c = runs[r].second;
+        // run names are algorithm names, nothing in them needs escaping
+        out << (r > 0 ? "," : "") << "\n    {\"algorithm\": \"" << runs[r].first << "\", \"simulate_seconds\": "
+            << c.simulate_seconds << ", \"output_seconds\": " << c.output_seconds << ",\n     \"iterations\": "
+            << c.iterations << ", \"events\": {";
+        for (int k = 0; k < NUM_EVENT_KINDS; ++k) {
+            out << (k > 0 ? ", " : "") << "\"" << event_kind_name((EventKind) k) << "\": " << c.events[k];
+        }
+        out << "},\n     \"ready_queue\": {\"pushes\": " << c.ready_pushes << ", \"pops\": " << c.ready_pops
+            << ", \"max_depth\": " << c.max_ready_depth << "}, \"io_queue\": {\"pushes\": " << c.io_pushes
+            << ", \"max_depth\": " << c.max_io_depth << "}, \"preemptions\": " << c.preemptions
+            << ",\n     \"arena\": {\"requests\": " << c.arena_requests << ", \"fresh\": " << c.arena_fresh
+            << ", \"upstream\": " << c.arena_upstream << "}}";
+    }
+    out << (runs.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
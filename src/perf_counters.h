@@ -0,0 +1,103 @@
+#ifndef OPSYSPROJ_PERF_COUNTERS_H
+#define OPSYSPROJ_PERF_COUNTERS_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "event_log.h"
+
+/*
+ * What an engine's event loop did over one run, for telling where a slower run spends its time.
+ *
+ * Filled in only when the loop is instantiated with a Counted<> trace policy (see
+ * trace_policy.h): every update is behind Trace::counted, a constant, so the loops the
+ * simulations normally run are compiled without any counting code. Events are counted whether
+ * or not the trace keeps them.
+ */
+struct PerfCounters {
+    long long iterations;                // passes of the event loop
+    long long events[NUM_EVENT_KINDS];   // events handled, by kind
+    long long ready_pushes, ready_pops;  // processes added to / taken off the ready queue
+    int max_ready_depth;
+    long long io_pushes;                 // processes blocked on I/O
+    int max_io_depth;
+    int preemptions;                     // as counted in the run's statistics
+    size_t arena_requests, arena_fresh, arena_upstream;  // see Arena
+    double simulate_seconds;             // wall-clock time in the event loop
+    double output_seconds;               // wall-clock time handing the run to its sink
+
+    PerfCounters();
+
+    void handled(EventKind kind) { events[kind]++; }
+    // depth is the queue's length with the process in it
+    void ready_pushed(size_t depth) {
+        ready_pushes++;
+        if ((int) depth > max_ready_depth) {
+            max_ready_depth = (int) depth;
+        }
+    }
+    void ready_popped() { ready_pops++; }
+    void io_pushed(size_t depth) {
+        io_pushes++;
+        if ((int) depth > max_io_depth) {
+            max_io_depth = (int) depth;
+        }
+    }
+    // at the end of the run, what the engine's arena was asked for
+    void take_memory(const Arena& arena);
+};
+
+// the stages of a MAIN run that --perf times
+enum Phase {
+    PHASE_GENERATION,  // drawing the processes
+    PHASE_SORT,        // building the Workload: ordering by arrival and the Part I totals
+    PHASE_SIMULATE,    // the event loops
+    PHASE_OUTPUT,      // everything written to stdout and the output files
+    NUM_PHASES
+};
+
+const char* phase_name(Phase phase);
+
+// wall-clock seconds, lap() returns the time since the last lap (or construction)
+class Stopwatch {
+public:
+    Stopwatch() : last(clock::now()) {}
+
+    double lap() {
+        clock::time_point now = clock::now();
+        double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return seconds;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+    clock::time_point last;
+};
+
+/*
+ * The counters of every simulated run of one MAIN invocation, and its time per phase. Runs are
+ * kept in the order they were simulated, under the heading their statistics block has.
+ */
+class PerfReport {
+public:
+    PerfReport();
+
+    void add_time(Phase phase, double seconds) { phase_seconds[phase] += seconds; }
+    // a fresh set of counters for the run called name, valid until the next call
+    PerfCounters& start_run(const std::string& name);
+
+    // one JSON object: "phases" with the seconds per phase, "runs" with each run's counters;
+    // simulate and output include the per-run times, the rest is what main timed around them
+    void write_json(std::ostream& out) const;
+
+private:
+    double phase_seconds[NUM_PHASES];
+    std::vector<std::pair<std::string, PerfCounters> > runs;
+};
+
+#endif //OPSYSPROJ_PERF_COUNTERS_H
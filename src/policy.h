@@ -0,0 +1,16 @@
+#ifndef OPSYSPROJ_POLICY_H
+#define OPSYSPROJ_POLICY_H
+
+// the schedulers there are
+enum Policy {
+    POLICY_FCFS,
+    POLICY_SJF,
+    POLICY_SRT,
+    POLICY_RR,
+    POLICY_PRIO,   // the O(1) priority-array scheduler
+    NUM_POLICIES
+};
+
+const char* policy_name(Policy policy);
+
+#endif //OPSYSPROJ_POLICY_H
@@ -0,0 +1,396 @@
+#include "prio.h"
+#include "perf_counters.h"
+#include "run_budget.h"
+#include <iostream>
+#include <queue>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+const int prio::MAX_PRIO;
+const int prio::MAX_RT_PRIO;
+const int prio::MAX_BONUS;
+const int prio::BITMAP_WORDS;
+
+prio::prio(const Workload& workload, int context_time, int t_slc)
+        : workload(workload), t_cs(context_time), elapsed_time(0), t_slc(t_slc),
+          max_sleep_avg(std::max(1, t_slc * MAX_BONUS)), cpu_util(0.0), cpu_wait(0.0), io_wait(0.0), tot_wait(0.0),
+          cpu_turn(0.0), io_turn(0.0), tot_turn(0.0), num_cpu_switches(0), num_io_switches(0),
+          cpu_preempt(0), io_preempt(0), queue_snapshot(ArenaAllocator<int>(&arena)), log("O(1)"),
+          counters(nullptr), budget(nullptr) {
+    for (int a = 0; a < 2; ++a) {
+        arrays[a].nr_active = 0;
+        std::fill(arrays[a].bitmap, arrays[a].bitmap + BITMAP_WORDS, 0ULL);
+        std::fill(arrays[a].head, arrays[a].head + MAX_PRIO, -1);
+        std::fill(arrays[a].tail, arrays[a].tail + MAX_PRIO, -1);
+    }
+    active = &arrays[0];
+    expired = &arrays[1];
+}
+
+// appends process p to the end of its dynamic priority list and marks the list non-empty
+void prio::enqueue(prio_array* array, int p) {
+    int pr = tasks[p].dynamic_prio;
+    next_in_list[p] = -1;
+    if (array->tail[pr] == -1) {
+        array->head[pr] = p;
+        array->bitmap[pr / 64] |= 1ULL << (pr % 64);
+    } else {
+        next_in_list[array->tail[pr]] = p;
+    }
+    array->tail[pr] = p;
+    array->nr_active++;
+}
+
+// index of the lowest set bit in the array's bitmap, i.e. the best non-empty priority
+int prio::find_first_bit(const prio_array* array) {
+    for (int w = 0; w < BITMAP_WORDS; ++w) {
+        if (array->bitmap[w] != 0) {
+            return w * 64 + __builtin_ctzll(array->bitmap[w]);
+        }
+    }
+    return MAX_PRIO;
+}
+
+// removes and returns the head of the highest priority list
+int prio::dequeue_first(prio_array* array) {
+    int pr = find_first_bit(array);
+    int p = array->head[pr];
+    array->head[pr] = next_in_list[p];
+    if (array->head[pr] == -1) {
+        array->tail[pr] = -1;
+        array->bitmap[pr / 64] &= ~(1ULL << (pr % 64));
+    }
+    array->nr_active--;
+    return p;
+}
+
+// static priority plus the interactivity bonus earned by sleeping on I/O
+int prio::effective_prio(int p) const {
+    int bonus = (int) ((long long) tasks[p].sleep_avg * MAX_BONUS / max_sleep_avg);
+    int pr = tasks[p].static_prio - bonus + MAX_BONUS / 2;
+    return std::max(MAX_RT_PRIO, std::min(MAX_PRIO - 1, pr));
+}
+
+// nice 0 gets the full t_slice, lower static priorities get proportionally less
+int prio::task_timeslice(int p) const {
+    return std::max(1, t_slc * (MAX_PRIO - tasks[p].static_prio) / 20);
+}
+
+EventRecord& prio::log_event(EventKind kind, int p, int a, int b) {
+    queue_snapshot.clear();
+    const prio_array* order[2] = {active, expired};
+    for (int k = 0; k < 2; ++k) {
+        for (int pr = find_first_bit(order[k]); pr < MAX_PRIO; ++pr) {
+            for (int q = order[k]->head[pr]; q != -1; q = next_in_list[q]) {
+                queue_snapshot.push_back(q);
+            }
+        }
+    }
+    return log.record(elapsed_time, kind, p, a, b, queue_snapshot.begin(), queue_snapshot.end());
+}
+
+template <class Trace>
+void prio::run() {
+    if (Trace::counted) {
+        counters->handled(EV_SIM_START);
+    }
+    if (Trace::enabled) {
+        log_event(EV_SIM_START);
+    }
+
+    const int n = workload.size();
+    tasks.assign(n, task());
+    next_in_list.assign(n, -1);
+    for (int p = 0; p < n; ++p) {
+        tasks[p].static_prio = workload.is_cpu_bound(p) ? 125 : 120;
+        tasks[p].sleep_avg = 0;
+    }
+
+    enum { CPU_IDLE, CPU_SWITCH_IN, CPU_RUNNING, CPU_SWITCH_OUT } cpu_state = CPU_IDLE;
+    sim_time cpu_event = -1; // time the current cpu_state ends
+    int running = -1;        // process that owns the CPU (switching in, running or switching out)
+    sim_time run_started = 0;
+    int requeue = -1;        // process to put back in a ready queue once it has switched out
+    bool requeue_expired = false;
+
+    arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > > io_queue =
+            make_arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > >(arena);
+    int i = 0;
+    int processes_killed = 0;
+    long long total_cpu_time = 0;
+    long long cpu_bound_wait_time = 0, io_bound_wait_time = 0;
+    long long cpu_bound_turnaround_time = 0, io_bound_turnaround_time = 0;
+    int cpu_bound_bursts = 0, io_bound_bursts = 0;
+
+    while (processes_killed < n || cpu_state != CPU_IDLE) {
+        if (Trace::counted) {
+            counters->iterations++;
+        }
+        if (budget != nullptr && budget->spent()) {
+            break;  // out of time, the caller throws the statistics away
+        }
+        // dispatch: O(1) pick of the best runnable process, swapping arrays if active is drained
+        if (cpu_state == CPU_IDLE && active->nr_active + expired->nr_active > 0) {
+            if (active->nr_active == 0) {
+                std::swap(active, expired);
+            }
+            running = dequeue_first(active);
+            if (Trace::counted) {
+                counters->ready_popped();
+            }
+            sim_time wait_time = elapsed_time - tasks[running].entered_queue;
+            if (workload.is_cpu_bound(running)) {
+                cpu_bound_wait_time += wait_time;
+                num_cpu_switches++;
+            } else {
+                io_bound_wait_time += wait_time;
+                num_io_switches++;
+            }
+            cpu_state = CPU_SWITCH_IN;
+            cpu_event = elapsed_time + t_cs / 2;
+            continue;
+        }
+
+        sim_time next = std::numeric_limits<sim_time>::max();
+        if (cpu_state != CPU_IDLE) next = cpu_event;
+        if (!io_queue.empty()) next = std::min(next, io_queue.top().first);
+        if (i < n) next = std::min<sim_time>(next, workload.arrival_time(i));
+        elapsed_time = next;
+
+        // (a) CPU events come first at any given time
+        if (cpu_state != CPU_IDLE && cpu_event == elapsed_time) {
+            task& t = tasks[running];
+            if (cpu_state == CPU_SWITCH_IN) {
+                int burst_len = workload.burst(running, t.burst);
+                if (Trace::counted) {
+                    counters->handled(t.remaining == burst_len ? EV_CPU_START : EV_CPU_RESUME);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    if (t.remaining == burst_len) {
+                        log_event(EV_CPU_START, running, burst_len).with_prio(t.dynamic_prio);
+                    } else {
+                        log_event(EV_CPU_RESUME, running, t.remaining, burst_len).with_prio(t.dynamic_prio);
+                    }
+                }
+                run_started = elapsed_time;
+                cpu_state = CPU_RUNNING;
+                cpu_event = elapsed_time + std::min(t.remaining, t.time_slice);
+            } else if (cpu_state == CPU_RUNNING) {
+                int ran = (int) (elapsed_time - run_started);
+                t.remaining -= ran;
+                t.time_slice -= ran;
+                t.sleep_avg = std::max(0, t.sleep_avg - ran);
+                total_cpu_time += ran;
+
+                if (t.remaining == 0) {
+                    long long turn_around = elapsed_time + t_cs / 2 - t.burst_started;
+                    if (workload.is_cpu_bound(running)) {
+                        cpu_bound_turnaround_time += turn_around;
+                        cpu_bound_bursts++;
+                    } else {
+                        io_bound_turnaround_time += turn_around;
+                        io_bound_bursts++;
+                    }
+                    t.burst += 2;
+                    if (t.burst >= workload.num_bursts(running)) {
+                        if (Trace::counted) {
+                            counters->handled(EV_TERMINATED);
+                        }
+                        if (Trace::enabled) {
+                            log_event(EV_TERMINATED, running);
+                        }
+                        processes_killed++;
+                    } else {
+                        int to_go = (workload.num_bursts(running) - t.burst + 1) / 2;
+                        sim_time io_done = elapsed_time + t_cs / 2 + workload.burst(running, t.burst - 1);
+                        t.remaining = workload.burst(running, t.burst);
+                        io_queue.push(std::make_pair(io_done, running));
+                        if (Trace::counted) {
+                            counters->handled(EV_BURST_DONE);
+                            counters->handled(EV_IO_BLOCK);
+                            counters->io_pushed(io_queue.size());
+                        }
+                        if (Trace::windowed(elapsed_time)) {
+                            log_event(EV_BURST_DONE, running, to_go).with_prio(t.dynamic_prio);
+                            log_event(EV_IO_BLOCK, running, (int) (io_done - elapsed_time));
+                        }
+                    }
+                    requeue = -1;
+                    cpu_state = CPU_SWITCH_OUT;
+                    cpu_event = elapsed_time + t_cs / 2;
+                } else if (active->nr_active + expired->nr_active == 0) {
+                    // slice used up but nobody is waiting, so keep going with a fresh slice
+                    t.dynamic_prio = effective_prio(running);
+                    t.time_slice = task_timeslice(running);
+                    if (Trace::counted) {
+                        counters->handled(EV_SLICE_EMPTY);
+                    }
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(EV_SLICE_EMPTY);
+                    }
+                    run_started = elapsed_time;
+                    cpu_event = elapsed_time + std::min(t.remaining, t.time_slice);
+                } else {
+                    t.dynamic_prio = effective_prio(running);
+                    t.time_slice = task_timeslice(running);
+                    if (workload.is_cpu_bound(running)) {
+                        cpu_preempt++;
+                    } else {
+                        io_preempt++;
+                    }
+                    if (Trace::counted) {
+                        counters->handled(EV_SLICE_EXPIRED);
+                    }
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(EV_SLICE_EXPIRED, running, t.remaining);
+                    }
+                    requeue = running;
+                    requeue_expired = true;
+                    cpu_state = CPU_SWITCH_OUT;
+                    cpu_event = elapsed_time + t_cs / 2;
+                }
+            } else {
+                if (requeue != -1) {
+                    tasks[requeue].entered_queue = elapsed_time;
+                    enqueue(requeue_expired ? expired : active, requeue);
+                    if (Trace::counted) {
+                        counters->ready_pushed(active->nr_active + expired->nr_active);
+                    }
+                    requeue = -1;
+                }
+                running = -1;
+                cpu_state = CPU_IDLE;
+            }
+        }
+
+        // (c) I/O completions then (d) arrivals, both may preempt a lower priority running process
+        while (true) {
+            bool io_now = !io_queue.empty() && io_queue.top().first == elapsed_time;
+            bool arrival_now = i < n && workload.arrival_time(i) == elapsed_time;
+            if (!io_now && !arrival_now) {
+                break;
+            }
+            int p;
+            EventKind what;
+            if (io_now) {
+                p = io_queue.top().second;
+                io_queue.pop();
+                tasks[p].sleep_avg = std::min(max_sleep_avg, tasks[p].sleep_avg + workload.burst(p, tasks[p].burst - 1));
+                what = EV_IO_DONE;
+            } else {
+                p = i++;
+                tasks[p].burst = 0;
+                tasks[p].remaining = workload.burst(p, 0);
+                tasks[p].time_slice = task_timeslice(p);
+                what = EV_ARRIVAL;
+            }
+            tasks[p].dynamic_prio = effective_prio(p);
+            tasks[p].entered_queue = tasks[p].burst_started = elapsed_time;
+            enqueue(active, p);
+            if (Trace::counted) {
+                counters->ready_pushed(active->nr_active + expired->nr_active);
+                counters->handled(what);
+            }
+
+            if (cpu_state == CPU_RUNNING && tasks[p].dynamic_prio < tasks[running].dynamic_prio) {
+                task& r = tasks[running];
+                int ran = (int) (elapsed_time - run_started);
+                r.remaining -= ran;
+                r.time_slice -= ran;
+                r.sleep_avg = std::max(0, r.sleep_avg - ran);
+                total_cpu_time += ran;
+                if (workload.is_cpu_bound(running)) {
+                    cpu_preempt++;
+                } else {
+                    io_preempt++;
+                }
+                if (Trace::counted) {
+                    counters->handled(EV_PREEMPT);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(EV_PREEMPT, p, running, what).with_prio(tasks[p].dynamic_prio);
+                }
+                requeue = running;
+                requeue_expired = false;
+                cpu_state = CPU_SWITCH_OUT;
+                cpu_event = elapsed_time + t_cs / 2;
+            } else if (Trace::windowed(elapsed_time)) {
+                log_event(what, p).with_prio(tasks[p].dynamic_prio);
+            }
+        }
+    }
+
+    if (Trace::enabled) {
+        log_event(EV_SIM_END);
+    }
+    if (Trace::counted) {
+        counters->handled(EV_SIM_END);
+        counters->preemptions = cpu_preempt + io_preempt;
+        counters->take_memory(arena);
+    }
+
+    cpu_util = elapsed_time > 0 ? (double) total_cpu_time / elapsed_time : 0.0;
+    cpu_wait = cpu_bound_bursts > 0 ? (double) cpu_bound_wait_time / cpu_bound_bursts : 0.0;
+    io_wait = io_bound_bursts > 0 ? (double) io_bound_wait_time / io_bound_bursts : 0.0;
+    cpu_turn = cpu_bound_bursts > 0 ? (double) cpu_bound_turnaround_time / cpu_bound_bursts : 0.0;
+    io_turn = io_bound_bursts > 0 ? (double) io_bound_turnaround_time / io_bound_bursts : 0.0;
+    if (cpu_bound_bursts + io_bound_bursts > 0) {
+        tot_wait = (double) (cpu_bound_wait_time + io_bound_wait_time) / (cpu_bound_bursts + io_bound_bursts);
+        tot_turn = (double) (cpu_bound_turnaround_time + io_bound_turnaround_time) / (cpu_bound_bursts + io_bound_bursts);
+    }
+}
+
+// runs the event loop instantiated for the requested trace level, keeping only what filter accepts,
+// and the counted one of it when there are counters to fill in
+void prio::simulate(TraceLevel level, const TraceFilter* filter, PerfCounters* counters, RunBudget* budget) {
+    log.set_filter(filter);
+    this->counters = counters;
+    this->budget = budget;
+    switch (level) {
+        case TRACE_OFF:
+            counters != nullptr ? run<Counted<TraceOff> >() : run<TraceOff>();
+            break;
+        case TRACE_CUTOFF:
+            counters != nullptr ? run<Counted<TraceCutoff> >() : run<TraceCutoff>();
+            break;
+        case TRACE_FULL:
+            counters != nullptr ? run<Counted<TraceFull> >() : run<TraceFull>();
+            break;
+    }
+}
+
+SimStats prio::statistics() const {
+    SimStats stats;
+    stats.cpu_util = cpu_util;
+    stats.cpu_wait = cpu_wait;
+    stats.io_wait = io_wait;
+    stats.tot_wait = tot_wait;
+    stats.cpu_turn = cpu_turn;
+    stats.io_turn = io_turn;
+    stats.tot_turn = tot_turn;
+    stats.num_cpu_switches = num_cpu_switches;
+    stats.num_io_switches = num_io_switches;
+    stats.cpu_preempt = cpu_preempt;
+    stats.io_preempt = io_preempt;
+    return stats;
+}
+
+void prio::write_statistics(const SimStats& stats, std::ostream& outfile) {
+    outfile << "Algorithm O(1)" << std::endl;
+    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (std::ceil(stats.cpu_util * 100000) / 1000) << "%" << std::endl;
+    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << stats.cpu_wait << " ms" << std::endl;
+    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << stats.io_wait << " ms" << std::endl;
+    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << stats.tot_wait << " ms" << std::endl;
+    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.cpu_turn << " ms" << std::endl;
+    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.io_turn << " ms" << std::endl;
+    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << stats.tot_turn << " ms" << std::endl;
+    outfile << "-- CPU-bound number of context switches: " << stats.num_cpu_switches << std::endl;
+    outfile << "-- I/O-bound number of context switches: " << stats.num_io_switches << std::endl;
+    outfile << "-- overall number of context switches: " << stats.num_cpu_switches + stats.num_io_switches << std::endl;
+    outfile << "-- CPU-bound number of preemptions: " << stats.cpu_preempt << std::endl;
+    outfile << "-- I/O-bound number of preemptions: " << stats.io_preempt << std::endl;
+    outfile << "-- overall number of preemptions: " << stats.cpu_preempt + stats.io_preempt << std::endl << std::endl;
+}
@@ -0,0 +1,108 @@
+#ifndef OPSYSPROJ_PRIO_H
+#define OPSYSPROJ_PRIO_H
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <queue>
+#include <algorithm>
+#include "workload.h"
+#include "arena.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "sim_stats.h"
+
+struct PerfCounters;
+class RunBudget;
+
+/*
+ * Priority scheduler modeled on the old Linux O(1) scheduler.
+ *
+ * Runnable processes live in one of two priority arrays (active / expired). Each array has
+ * MAX_PRIO FIFO lists plus a bitmap with one bit per non-empty list, so picking the next
+ * process is a find-first-set over a few words no matter how many processes are runnable.
+ * A process that uses up its time slice moves to the expired array; once the active array
+ * drains the two arrays are swapped.
+ *
+ * Static priority comes from is_cpu_bound (CPU-bound processes get a nice of +5), and the
+ * dynamic priority adds a bonus computed from the I/O time the process has slept through.
+ */
+class prio {
+public:
+    static const int MAX_PRIO = 140;
+    static const int MAX_RT_PRIO = 100;
+    static const int MAX_BONUS = 10;
+    static const int BITMAP_WORDS = (MAX_PRIO + 63) / 64;
+
+    prio(const Workload& workload, int context_time, int t_slc);
+
+    // with counters given, the run also fills them in (see perf_counters.h); with a budget it stops
+    // once that is spent (see run_budget.h)
+    void simulate(TraceLevel level = TRACE_CUTOFF, const TraceFilter* filter = nullptr,
+                  PerfCounters* counters = nullptr, RunBudget* budget = nullptr);
+    SimStats statistics() const;
+    // writes the O(1) block for stats to out
+    static void write_statistics(const SimStats& stats, std::ostream& out);
+
+    // the arena the engine containers allocate from, to check the event loop stays allocation-free
+    const Arena& memory() const { return arena; }
+
+    // everything the simulation traced, render() it to get the text
+    const EventLog& events() const { return log; }
+    // the same log, for handing it a drain (see EventLog::set_drain()) before simulate()
+    EventLog& events() { return log; }
+
+private:
+    // the event loop, instantiated once per trace policy (see trace_policy.h)
+    template <class Trace>
+    void run();
+
+    // one of the two priority arrays, lists are intrusive through prio::next_in_list
+    struct prio_array {
+        int nr_active;
+        unsigned long long bitmap[BITMAP_WORDS];
+        int head[MAX_PRIO];
+        int tail[MAX_PRIO];
+    };
+
+    // per-process scheduling state, indexed by workload handle
+    struct task {
+        int static_prio;
+        int dynamic_prio;
+        int sleep_avg;           // ms of I/O slept through, capped at max_sleep_avg
+        int time_slice;          // ms left in the current slice
+        int burst;               // index of the current CPU burst in the workload
+        int remaining;           // ms left in the current CPU burst
+        sim_time entered_queue;  // time the process was last added to a ready queue
+        sim_time burst_started;  // time the current CPU burst first entered the ready queue
+    };
+
+    const Workload& workload;
+    Arena arena; // everything the simulation allocates, freed when the scheduler goes away
+    std::vector<task> tasks;
+    std::vector<int> next_in_list;
+    prio_array arrays[2];
+    prio_array *active, *expired;
+
+    int t_cs;
+    sim_time elapsed_time;
+    int t_slc, max_sleep_avg;
+    double cpu_util, cpu_wait, io_wait, tot_wait, cpu_turn, io_turn, tot_turn;
+    int num_cpu_switches, num_io_switches, cpu_preempt, io_preempt;
+
+    void enqueue(prio_array* array, int p);
+    int dequeue_first(prio_array* array);
+    static int find_first_bit(const prio_array* array);
+    int effective_prio(int p) const;
+    int task_timeslice(int p) const;
+
+    arena_vector<int> queue_snapshot;  // scratch space for logging both arrays in dispatch order
+    EventLog log;                      // trace of the run, rendered on demand
+    PerfCounters* counters;            // what a counted run fills in, nullptr otherwise
+    RunBudget* budget;                 // stops the run when spent, nullptr for no limit
+
+    // records an event stamped with the current time, along with the ready queue as it stands
+    EventRecord& log_event(EventKind kind, int p = -1, int a = 0, int b = 0);
+};
+
+#endif //OPSYSPROJ_PRIO_H
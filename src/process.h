@@ -6,27 +6,73 @@
 #define OPSYSPROJ_PROCESS_H
 
 #include <string>
-#include <vector>
+#include <cassert>
+#include <cstddef>
 
+/*
+ * Fixed-capacity burst list stored inline in a Process. generate_processes draws at most 32 CPU
+ * bursts per process with an I/O burst between each pair, so no process ever has more than
+ * 32 + 31 bursts and generating or copying a Process never touches the heap.
+ */
+class BurstArray {
+public:
+    static const int CAPACITY = 63;
+
+    BurstArray() : count(0) {}
+
+    void push_back(int burst) {
+        assert(count < CAPACITY);
+        values[count++] = burst;
+    }
+    void clear() { count = 0; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    int& operator[](size_t i) { return values[i]; }
+    int operator[](size_t i) const { return values[i]; }
+
+    const int* begin() const { return values; }
+    const int* end() const { return values + count; }
+
+private:
+    int values[CAPACITY];
+    unsigned char count;
+};
+
+// immutable workload data for one process, only read when generating and printing
 class Process {
 public:
-    std::string id; // PID
+    std::string id; // PID, always short enough for the small-string buffer
     int arrival_time;
-    std::vector<int> bursts; // burst times
+    BurstArray bursts; // burst times
     bool is_cpu_bound;
-    double tau; // added this for sjf and srt
-    int remaining_time;  // Remaining time for the current CPU burst
-
-    Process() : id(""), arrival_time(0), tau(0), remaining_time(0) {}
 
-    Process(const std::string& id, const std::vector<int>& bursts, int arrival_time, int tau)
-            : id(id), arrival_time(arrival_time), bursts(bursts), tau(tau), remaining_time(0) {}
+    Process() : id(""), arrival_time(0), is_cpu_bound(false) {}
 
     bool operator==(const Process &other) const {
         return this->id == other.id;
     }
 };
 
+/*
+ * The hot per-process scheduling state, one record per workload handle in a contiguous array
+ * owned by each scheduler. Ready queues hold handles into that array, so everything the event
+ * loop touches for a process sits in a single cache line and the cold Process/Workload data
+ * (PID strings, arrival times) is only looked up when printing.
+ */
+struct ProcState {
+    double tau;               // predicted CPU burst (sjf, srt)
+    int remaining;            // ms left in the current burst
+    int burst_len;            // full length of the CPU burst in progress, 0 if none has started (rr)
+    int id_rank;              // Workload::id_rank(), so tie-breaks by process ID compare ints
+    unsigned short cursor;    // index of the next burst in the workload, never more than 63
+    unsigned char cpu_bound;  // copy of is_cpu_bound so statistics don't touch the workload
+    unsigned char unused;
+};
+
+static_assert(sizeof(ProcState) <= 24, "ProcState should stay small enough to pack into cache lines");
+
 //Process& Process::operator=(const Process &other) {
 //    // Check for self-assignment
 //    if (this == &other)
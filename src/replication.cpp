@@ -0,0 +1,297 @@
+#include "replication.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <thread>
+#include "generator.h"
+
+const char* metric_name(Metric metric) {
+    static const char* const names[NUM_METRICS] = {
+            "overall average wait time", "overall average turnaround time", "CPU utilization"};
+    return names[metric];
+}
+
+// unit the metric is printed with
+static const char* metric_unit(Metric metric) {
+    return metric == METRIC_UTILIZATION ? "%" : " ms";
+}
+
+double metric_value(const SimStats& stats, Metric metric) {
+    switch (metric) {
+        case METRIC_WAIT:
+            return stats.tot_wait;
+        case METRIC_TURNAROUND:
+            return stats.tot_turn;
+        case METRIC_UTILIZATION:
+            return stats.cpu_util * 100;
+        default:
+            return 0;
+    }
+}
+
+// every policy not skipped on the workload generated from rng, fixed_draws as for generate_processes()
+static void observe(const ExperimentConfig& config, RandomGenerator& rng, bool fixed_draws, double weight,
+                    const bool* skip, Observation& out) {
+    Workload workload(generate_processes(rng, config.n, config.ncpu, config.lambda, config.bound, fixed_draws));
+    SimParams params;
+    params.t_cs = config.t_cs;
+    params.alpha = config.alpha;
+    params.lambda = config.lambda;
+    params.t_slice = config.t_slice;
+    for (int p = 0; p < NUM_POLICIES; ++p) {
+        if (skip != nullptr && skip[p]) {
+            std::fill(out.value[p], out.value[p] + NUM_METRICS, std::numeric_limits<double>::quiet_NaN());
+            continue;
+        }
+        SimStats stats = simulate(workload, (Policy) p, params);
+        for (int m = 0; m < NUM_METRICS; ++m) {
+            out.value[p][m] += weight * metric_value(stats, (Metric) m);
+        }
+    }
+}
+
+Observation run_replication(const ExperimentConfig& config, long seed, bool antithetic, const bool* skip) {
+    Observation observation;
+    std::fill(&observation.value[0][0], &observation.value[0][0] + NUM_POLICIES * NUM_METRICS, 0.0);
+    RandomGenerator rng(seed);
+    // the pair must take the same number of draws for every burst, or it stops being a pair
+    // at the first redraw
+    observe(config, rng, antithetic, antithetic ? 0.5 : 1.0, skip, observation);
+    if (antithetic) {
+        RandomGenerator mirror(seed, true);
+        observe(config, mirror, true, 0.5, skip, observation);
+    }
+    return observation;
+}
+
+double student_t95(int dof) {
+    static const double table[30] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof < 1) {
+        return INFINITY;
+    }
+    if (dof <= 30) {
+        return table[dof - 1];
+    }
+    // first-order expansion around the normal quantile, within 0.001 of the exact value past 30
+    return 1.95996 + 2.37227 / dof;
+}
+
+// unbiased sample variance, 0 for fewer than two values
+static double variance(const std::vector<double>& sample) {
+    if (sample.size() < 2) {
+        return 0;
+    }
+    double sum = 0;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        sum += sample[i];
+    }
+    const double mean = sum / sample.size();
+    double squares = 0;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        squares += (sample[i] - mean) * (sample[i] - mean);
+    }
+    return squares / (sample.size() - 1);
+}
+
+double Interval::relative_half_width() const {
+    if (mean == 0) {
+        return half_width == 0 ? 0 : INFINITY;
+    }
+    return half_width / std::fabs(mean);
+}
+
+Interval confidence_interval(const std::vector<double>& sample) {
+    Interval interval;
+    interval.samples = (int) sample.size();
+    interval.mean = 0;
+    interval.half_width = INFINITY;
+    if (sample.empty()) {
+        return interval;
+    }
+    double sum = 0;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        sum += sample[i];
+    }
+    interval.mean = sum / sample.size();
+    if (sample.size() > 1) {
+        interval.half_width = student_t95((int) sample.size() - 1) * std::sqrt(variance(sample) / sample.size());
+    }
+    return interval;
+}
+
+ReplicationStudy::ReplicationStudy(const ExperimentConfig& config, long first_seed, bool antithetic)
+        : config(config), first_seed(first_seed), antithetic(antithetic) {
+    std::fill(&frozen[0][0], &frozen[0][0] + NUM_POLICIES * NUM_METRICS, 0);
+}
+
+void ReplicationStudy::run(int count) {
+    for (int r = 0; r < count; ++r) {
+        add(run_replication(config, next_seed(), antithetic));
+    }
+}
+
+// a few replications before an interval is trusted, t is still huge and the variance a guess
+static const int MIN_ADAPTIVE_REPLICATIONS = 5;
+
+void ReplicationStudy::run_adaptive(double target, int budget, int threads) {
+    threads = std::max(threads, 1);
+    bool skip[NUM_POLICIES];
+    while (size() < budget) {
+        int active = 0;
+        for (int p = 0; p < NUM_POLICIES; ++p) {
+            skip[p] = true;
+            for (int m = 0; m < NUM_METRICS; ++m) {
+                skip[p] = skip[p] && frozen[p][m] > 0;
+            }
+            active += !skip[p];
+        }
+        if (active == 0) {
+            break;
+        }
+
+        // one batch, each replication in its own thread; results are added in seed order so the
+        // study is the same whatever the thread count
+        int batch = std::min(threads, budget - size());
+        std::vector<Observation> results(batch);
+        std::vector<std::thread> workers;
+        const long seed = next_seed();
+        for (int b = 0; b < batch; ++b) {
+            workers.push_back(std::thread([this, &results, &skip, seed, b]() {
+                results[b] = run_replication(config, seed + b, antithetic, skip);
+            }));
+        }
+        for (int b = 0; b < batch; ++b) {
+            workers[b].join();
+        }
+        for (int b = 0; b < batch; ++b) {
+            add(results[b]);
+        }
+
+        if (size() < MIN_ADAPTIVE_REPLICATIONS) {
+            continue;
+        }
+        for (int p = 0; p < NUM_POLICIES; ++p) {
+            for (int m = 0; m < NUM_METRICS; ++m) {
+                if (frozen[p][m] == 0 && interval((Policy) p, (Metric) m).relative_half_width() <= target) {
+                    frozen[p][m] = size();
+                }
+            }
+        }
+    }
+}
+
+void ReplicationStudy::add(const Observation& observation) {
+    observations.push_back(observation);
+}
+
+int ReplicationStudy::replications(Policy policy, Metric metric) const {
+    return frozen[policy][metric] > 0 ? frozen[policy][metric] : size();
+}
+
+std::vector<double> ReplicationStudy::sample(Policy policy, Metric metric) const {
+    std::vector<double> values(replications(policy, metric));
+    for (size_t r = 0; r < values.size(); ++r) {
+        values[r] = observations[r].value[policy][metric];
+    }
+    return values;
+}
+
+std::vector<double> ReplicationStudy::differences(Policy a, Policy b, Metric metric) const {
+    std::vector<double> values(std::min(replications(a, metric), replications(b, metric)));
+    for (size_t r = 0; r < values.size(); ++r) {
+        values[r] = observations[r].value[a][metric] - observations[r].value[b][metric];
+    }
+    return values;
+}
+
+Interval ReplicationStudy::interval(Policy policy, Metric metric) const {
+    return confidence_interval(sample(policy, metric));
+}
+
+Interval ReplicationStudy::paired_difference(Policy a, Policy b, Metric metric) const {
+    return confidence_interval(differences(a, b, metric));
+}
+
+double ReplicationStudy::variance_reduction(Policy a, Policy b, Metric metric) const {
+    // independent runs of a and b would give a difference with variance var(a) + var(b)
+    double paired = variance(differences(a, b, metric));
+    double independent = variance(sample(a, metric)) + variance(sample(b, metric));
+    return paired > 0 ? independent / paired : INFINITY;
+}
+
+bool ReplicationStudy::plausible(Policy policy) const {
+    for (size_t r = 0; r < observations.size(); ++r) {
+        // a skipped policy's NaNs fail both comparisons
+        if (observations[r].value[policy][METRIC_UTILIZATION] > 100 ||
+            observations[r].value[policy][METRIC_TURNAROUND] == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// orders policies by their mean on one metric, smallest first
+struct CompareMean {
+    const ReplicationStudy* study;
+    Metric metric;
+
+    bool operator()(int a, int b) const {
+        return study->interval((Policy) a, metric).mean < study->interval((Policy) b, metric).mean;
+    }
+};
+
+void ReplicationStudy::write_report(std::ostream& out) const {
+    out << "Replications: " << size() << " (seeds " << first_seed << "-" << next_seed() - 1
+        << (antithetic ? ", each with its antithetic replica, drawn with fixed draws per process" : "") << ")"
+        << std::endl;
+    for (int p = 0; p < NUM_POLICIES; ++p) {
+        if (!plausible((Policy) p)) {
+            out << "Not ranked: " << policy_name((Policy) p) << ", whose statistics cannot be right"
+                << " (over 100% CPU utilization or a zero average turnaround)" << std::endl;
+        }
+    }
+    out << std::fixed << std::setprecision(3);
+    for (int m = 0; m < NUM_METRICS; ++m) {
+        const Metric metric = (Metric) m;
+        out << "Metric " << metric_name(metric) << std::endl;
+
+        std::vector<int> ranking;
+        for (int p = 0; p < NUM_POLICIES; ++p) {
+            if (plausible((Policy) p)) {
+                ranking.push_back(p);
+            }
+        }
+        CompareMean by_mean = {this, metric};
+        std::stable_sort(ranking.begin(), ranking.end(), by_mean);
+        for (size_t k = 0; k < ranking.size(); ++k) {
+            Interval i = interval((Policy) ranking[k], metric);
+            out << "-- " << policy_name((Policy) ranking[k]) << ": " << i.mean << " +/- " << i.half_width
+                << metric_unit(metric);
+            if (converged((Policy) ranking[k], metric)) {
+                out << " (converged after " << i.samples << " replications)";
+            }
+            out << std::endl;
+        }
+        // a policy whose numbers cannot be right would only distort the ranking and its differences
+        for (int p = 0; p < NUM_POLICIES; ++p) {
+            if (!plausible((Policy) p)) {
+                Interval i = interval((Policy) p, metric);
+                out << "-- " << policy_name((Policy) p) << ": " << i.mean << " +/- " << i.half_width
+                    << metric_unit(metric) << " (not ranked)" << std::endl;
+            }
+        }
+        // neighbours in the ranking, which is where a difference may not be significant
+        for (size_t k = 1; k < ranking.size(); ++k) {
+            Policy a = (Policy) ranking[k], b = (Policy) ranking[k - 1];
+            Interval d = paired_difference(a, b, metric);
+            out << "-- " << policy_name(a) << " - " << policy_name(b) << ": " << d.mean << " +/- " << d.half_width
+                << metric_unit(metric) << (d.excludes_zero() ? " (significant" : " (not significant")
+                << ", " << std::setprecision(1) << variance_reduction(a, b, metric)
+                << "x less variance than independent runs)" << std::setprecision(3) << std::endl;
+        }
+    }
+}
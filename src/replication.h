@@ -0,0 +1,121 @@
+#ifndef OPSYSPROJ_REPLICATION_H
+#define OPSYSPROJ_REPLICATION_H
+
+#include <ostream>
+#include <vector>
+#include "sim_stats.h"
+#include "simulate.h"
+#include "workload.h"
+
+// the numbers a replication study compares the policies on
+enum Metric {
+    METRIC_WAIT,         // overall average wait time, ms
+    METRIC_TURNAROUND,   // overall average turnaround time, ms
+    METRIC_UTILIZATION,  // CPU utilization, %
+    NUM_METRICS
+};
+
+const char* metric_name(Metric metric);
+double metric_value(const SimStats& stats, Metric metric);
+
+// everything that decides a run apart from the seed: the generator's and the schedulers' parameters
+struct ExperimentConfig {
+    int n, ncpu;
+    double lambda;
+    int bound;
+    int t_cs;
+    double alpha;
+    int t_slice;
+};
+
+// every metric of every policy for one replication
+struct Observation {
+    double value[NUM_POLICIES][NUM_METRICS];
+};
+
+/*
+ * Runs one replication: the workload for seed is generated once and fed to every policy, so
+ * differences between policies are not blurred by differences between workloads (common random
+ * numbers). With antithetic set, a second workload is drawn from the 1 - u stream of the same
+ * seed, and the observation is the average of the two runs; both workloads are then generated
+ * with fixed_draws (see generate_processes()), so they differ from a plain run of the seed.
+ * Policies whose entry in skip is set are not run and get NaN for every metric.
+ */
+Observation run_replication(const ExperimentConfig& config, long seed, bool antithetic,
+                            const bool* skip = nullptr);
+
+// mean of a sample and the half-width of its 95% confidence interval
+struct Interval {
+    double mean;
+    double half_width;
+    int samples;
+
+    // the interval does not contain zero
+    bool excludes_zero() const { return mean - half_width > 0 || mean + half_width < 0; }
+    // half-width relative to the mean, 0 for an interval that is exactly {0}
+    double relative_half_width() const;
+};
+
+// two-sided 95% quantile of Student's t distribution with dof degrees of freedom
+double student_t95(int dof);
+Interval confidence_interval(const std::vector<double>& sample);
+
+/*
+ * A set of replications of one experiment, run on seeds first_seed, first_seed + 1, ...
+ *
+ * Policies are compared through paired differences: replication r gives one difference per
+ * pair of policies, all measured on the same workload, and the confidence interval is taken
+ * over those differences. Workload randomness cancels out of each difference, so the interval
+ * is usually much narrower than one built from independent runs of each policy would be with
+ * the same number of replications. Once run_adaptive() has frozen some estimates, a difference
+ * is taken over the replications both policies still have values for.
+ */
+class ReplicationStudy {
+public:
+    ReplicationStudy(const ExperimentConfig& config, long first_seed, bool antithetic);
+
+    // runs count more replications
+    void run(int count);
+    /*
+     * Runs replications in batches of threads at a time, one thread per replication, until every
+     * policy's interval on every metric has a relative half-width of at most target, or budget
+     * replications have been run. A metric's estimate is frozen as soon as it is narrow enough,
+     * and a policy stops being simulated once all of its metrics are frozen.
+     */
+    void run_adaptive(double target, int budget, int threads);
+    // adds a replication run elsewhere, in seed order
+    void add(const Observation& observation);
+
+    int size() const { return (int) observations.size(); }
+    // replications the estimate of metric for policy is based on
+    int replications(Policy policy, Metric metric) const;
+    // whether run_adaptive() stopped that estimate because it was narrow enough
+    bool converged(Policy policy, Metric metric) const { return frozen[policy][metric] > 0; }
+    long next_seed() const { return first_seed + size(); }
+    const ExperimentConfig& experiment() const { return config; }
+    bool uses_antithetic() const { return antithetic; }
+
+    Interval interval(Policy policy, Metric metric) const;
+    // a - b, paired by replication
+    Interval paired_difference(Policy a, Policy b, Metric metric) const;
+    // how many times more replications independent runs would need for the same interval width
+    double variance_reduction(Policy a, Policy b, Metric metric) const;
+    // false once a replication gave policy statistics no schedule can produce: over 100% CPU
+    // utilization, or an average turnaround of zero when every turnaround includes its burst
+    bool plausible(Policy policy) const;
+
+    // ranks the plausible policies on each metric and lists the others after them, unranked
+    void write_report(std::ostream& out) const;
+
+private:
+    ExperimentConfig config;
+    long first_seed;
+    bool antithetic;
+    std::vector<Observation> observations;
+    int frozen[NUM_POLICIES][NUM_METRICS]; // replication count an estimate was frozen at, 0 if it is not
+
+    std::vector<double> sample(Policy policy, Metric metric) const;
+    std::vector<double> differences(Policy a, Policy b, Metric metric) const;
+};
+
+#endif //OPSYSPROJ_REPLICATION_H
@@ -0,0 +1,184 @@
+#include "result_cache.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hash.h"
+#include "sim_time.h"
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'O', 'S', 'P', 'C', 'A', 'C', 'H', '1'};
+const off_t HEADER_SIZE = sizeof(INDEX_MAGIC);
+
+// one slot of the index, key 0 marks it empty
+struct IndexSlot {
+    uint64_t key;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t unused;
+};
+
+off_t slot_offset(uint32_t slot) {
+    return HEADER_SIZE + (off_t) slot * sizeof(IndexSlot);
+}
+
+// holds a flock for as long as it lives
+class FileLock {
+public:
+    FileLock(int fd, int operation) : fd(fd) { while (flock(fd, operation) != 0 && errno == EINTR) {} }
+    ~FileLock() { flock(fd, LOCK_UN); }
+
+private:
+    int fd;
+};
+
+bool read_all(int fd, void* data, size_t size, off_t offset) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t got = pread(fd, bytes, size, offset);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        size -= got;
+        offset += got;
+    }
+    return true;
+}
+
+bool write_all(int fd, const void* data, size_t size, off_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t put = pwrite(fd, bytes, size, offset);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return false;
+        }
+        bytes += put;
+        size -= put;
+        offset += put;
+    }
+    return true;
+}
+
+}
+
+const uint32_t ResultCache::INDEX_SLOTS;
+const uint32_t ResultCache::MAX_PROBES;
+
+ResultCache::ResultCache(const std::string& directory) : index_fd(-1), blocks_fd(-1) {
+    if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+        std::cerr << "warning: cannot create cache directory " << directory << ": " << std::strerror(errno)
+                  << ", running uncached" << std::endl;
+        return;
+    }
+    index_fd = open((directory + "/index").c_str(), O_RDWR | O_CREAT, 0666);
+    blocks_fd = open((directory + "/blocks").c_str(), O_RDWR | O_CREAT, 0666);
+    if (!enabled()) {
+        std::cerr << "warning: cannot open the cache in " << directory << ": " << std::strerror(errno)
+                  << ", running uncached" << std::endl;
+        return;
+    }
+
+    // the first process to get here lays out the empty table, everyone else checks it
+    FileLock lock(index_fd, LOCK_EX);
+    struct stat st;
+    char magic[sizeof(INDEX_MAGIC)];
+    bool valid = fstat(index_fd, &st) == 0;
+    if (valid && st.st_size == 0) {
+        valid = write_all(index_fd, INDEX_MAGIC, sizeof(INDEX_MAGIC), 0) &&
+                ftruncate(index_fd, slot_offset(INDEX_SLOTS)) == 0;
+    } else {
+        valid = valid && st.st_size == slot_offset(INDEX_SLOTS) &&
+                read_all(index_fd, magic, sizeof(magic), 0) && std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) == 0;
+    }
+    if (!valid) {
+        std::cerr << "warning: " << directory << "/index is not a cache index, running uncached" << std::endl;
+        close(index_fd);
+        close(blocks_fd);
+        index_fd = blocks_fd = -1;
+    }
+}
+
+ResultCache::~ResultCache() {
+    if (index_fd >= 0) {
+        close(index_fd);
+    }
+    if (blocks_fd >= 0) {
+        close(blocks_fd);
+    }
+}
+
+uint64_t ResultCache::key(const std::string& algorithm, int t_cs, double alpha, double lambda, int t_slice,
+                          uint64_t workload_hash) {
+    uint64_t h = fnv1a_string(SIMULATOR_VERSION);
+    h = fnv1a_string(algorithm, h);
+    h = fnv1a_value(t_cs, h);
+    h = fnv1a_value(alpha, h);
+    h = fnv1a_value(lambda, h);
+    h = fnv1a_value(t_slice, h);
+    h = fnv1a_value(workload_hash, h);
+    // a 32-bit clock wraps on runs a 64-bit one gets right, so the two builds never share entries
+    h = fnv1a_value((int) sizeof(sim_time), h);
+    return h != 0 ? h : 1;
+}
+
+bool ResultCache::lookup(uint64_t key, std::string& block) const {
+    if (!enabled()) {
+        return false;
+    }
+    FileLock lock(index_fd, LOCK_SH);
+    IndexSlot slot;
+    for (uint32_t probe = 0; probe < MAX_PROBES; ++probe) {
+        if (!read_all(index_fd, &slot, sizeof(slot), slot_offset((key + probe) % INDEX_SLOTS)) || slot.key == 0) {
+            return false;
+        }
+        if (slot.key == key) {
+            std::vector<char> text(slot.length);
+            if (slot.length > 0 && !read_all(blocks_fd, text.data(), slot.length, (off_t) slot.offset)) {
+                return false;
+            }
+            block.assign(text.begin(), text.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+void ResultCache::store(uint64_t key, const std::string& block) {
+    if (!enabled()) {
+        return;
+    }
+    FileLock lock(index_fd, LOCK_EX);
+    IndexSlot slot;
+    for (uint32_t probe = 0; probe < MAX_PROBES; ++probe) {
+        const off_t at = slot_offset((key + probe) % INDEX_SLOTS);
+        if (!read_all(index_fd, &slot, sizeof(slot), at) || slot.key == key) {
+            return; // unreadable, or another process stored it first
+        }
+        if (slot.key != 0) {
+            continue;
+        }
+        // the exclusive lock covers the blocks file too, so nobody else is appending
+        struct stat st;
+        if (fstat(blocks_fd, &st) != 0 || !write_all(blocks_fd, block.data(), block.size(), st.st_size)) {
+            return;
+        }
+        slot.key = key;
+        slot.offset = (uint64_t) st.st_size;
+        slot.length = (uint32_t) block.size();
+        slot.unused = 0;
+        write_all(index_fd, &slot, sizeof(slot), at);
+        return;
+    }
+}
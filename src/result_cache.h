@@ -0,0 +1,49 @@
+#ifndef OPSYSPROJ_RESULT_CACHE_H
+#define OPSYSPROJ_RESULT_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+// bump whenever a scheduler's numbers or a statistics block's text change, so old entries stop matching
+const char* const SIMULATOR_VERSION = "opsys-sim 2";
+
+/*
+ * On-disk cache of statistics blocks, so rerunning a configuration that was already simulated
+ * only costs a lookup.
+ *
+ * A directory holds two files. "blocks" is the text of every stored block, appended one after
+ * another. "index" is a fixed-size open-addressing hash table of (key, offset, length) slots
+ * into it, read and written in place with pread/pwrite, so a lookup touches a handful of slots
+ * whatever the number of entries and nothing has to be loaded up front.
+ *
+ * Any number of processes may share a directory: lookups hold a shared flock on the index and
+ * stores an exclusive one, and a store appends its block before it fills the slot pointing at
+ * it. A directory that cannot be opened leaves the cache disabled; lookups then miss and
+ * stores do nothing, so a run never fails because of its cache.
+ */
+class ResultCache {
+public:
+    explicit ResultCache(const std::string& directory);
+    ~ResultCache();
+
+    bool enabled() const { return index_fd >= 0 && blocks_fd >= 0; }
+
+    // the key of one statistics block: the algorithm, every parameter it reads, the workload and the simulator version
+    static uint64_t key(const std::string& algorithm, int t_cs, double alpha, double lambda, int t_slice,
+                        uint64_t workload_hash);
+
+    bool lookup(uint64_t key, std::string& block) const;
+    void store(uint64_t key, const std::string& block);
+
+    static const uint32_t INDEX_SLOTS = 1 << 16;
+    // a store gives up rather than probe further, the table is then as good as full
+    static const uint32_t MAX_PROBES = 64;
+
+private:
+    int index_fd, blocks_fd;
+
+    ResultCache(const ResultCache&);
+    ResultCache& operator=(const ResultCache&);
+};
+
+#endif //OPSYSPROJ_RESULT_CACHE_H
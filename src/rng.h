@@ -9,14 +9,18 @@
 // Class to handle the pseudo-random number generator state
 class RandomGenerator {
 public:
-    RandomGenerator(long seed) {
+    // antithetic generators return 1 - u for every u the plain one would, which gives a replica
+    // of the same seed whose draws are negatively correlated with it; u = 0 stays 0, since
+    // 1 - 0 would be an exact 1.0 and an exponential draw of 0 ms the plain stream never makes
+    RandomGenerator(long seed, bool antithetic = false) : antithetic(antithetic) {
         srand48(seed);
     }
 
     double drand48() {
         // generates a random double precision floating-point number between 0 and 1.
         my_seed = (0x5DEECE66DULL * my_seed + 0xB) & ((1ULL << 48) - 1);
-        return static_cast<double>(my_seed) / (1ULL << 48);
+        double u = static_cast<double>(my_seed) / (1ULL << 48);
+        return antithetic && u > 0 ? 1.0 - u : u;
     }
 
     void srand48(long seedval) {
@@ -26,6 +30,7 @@ public:
 
 private:
     unsigned long long my_seed;
+    bool antithetic;
 };
 
 
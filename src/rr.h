@@ -6,38 +6,68 @@
 #include <queue>
 #include <string>
 #include "rng.h"
-#include "process.h"
+#include "workload.h"
+#include "arena.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "sim_stats.h"
 #include <cmath>
 #include <algorithm>
 
+struct PerfCounters;
+class RunBudget;
 
 class rr {
 public:
-    rr(const std::vector<Process> &processes, int context_time, int t_slc)
-    : processes(processes), t_cs(context_time), elapsed_time(0), t_slc(t_slc), cpu_util(0.0),
+    // sets up the run, simulate() runs it
+    rr(const Workload &workload, int context_time, int t_slc)
+    : workload(workload), state(workload.initial_state(0)), q(ArenaAllocator<int>(&arena)), log("RR"), counters(nullptr), budget(nullptr), t_cs(context_time), t_slc(t_slc), elapsed_time(0), cpu_util(0.0),
     cpu_wait(0.0), io_wait(0.0), cpu_turn(0.0), io_turn(0.0), cpu_bursts_in_slice(0.0), io_bursts_in_slice(0.0),
-    total_in_slice(0.0), num_cpu_switches(0), num_io_switches(0), cpu_preempt(0), io_preempt(0){
-        simulate();
-    }
+    total_in_slice(0.0), num_cpu_switches(0), num_io_switches(0), cpu_preempt(0), io_preempt(0) {}
 
-    void simulate();
-    void write_statistics(const std::string& filename);
+    // with counters given, the run also fills them in (see perf_counters.h); with a budget it stops
+    // once that is spent (see run_budget.h)
+    void simulate(TraceLevel level = TRACE_CUTOFF, const TraceFilter* filter = nullptr,
+                  PerfCounters* counters = nullptr, RunBudget* budget = nullptr);
+    SimStats statistics() const;
+    // writes the RR block for stats to out under heading; the --rr-slices blocks have their own
+    static void write_statistics(const SimStats& stats, std::ostream& out,
+                                 const std::string& heading = "Algorithm RR");
+    // the arena the engine containers allocate from, to check the event loop stays allocation-free
+    const Arena& memory() const { return arena; }
+    // everything the simulation traced, render() it to get the text
+    const EventLog& events() const { return log; }
+    // the same log, for handing it a drain (see EventLog::set_drain()) before simulate()
+    EventLog& events() { return log; }
 
 
 private:
-    std::vector<Process> processes;
-    std::queue<Process> q; /* this would be a p queue for other algos */
-    int t_cs, elapsed_time, t_slc;
+    // the event loop, instantiated once per trace policy (see trace_policy.h)
+    template <class Trace>
+    void run();
+
+    const Workload& workload;
+    std::vector<ProcState> state; // hot per-process state, remaining is what is left of the current burst
+    Arena arena; // everything the simulation allocates, freed when the scheduler goes away
+    arena_deque<int> q; /* this would be a p queue for other algos */
+    EventLog log; // trace of the run, rendered on demand
+    PerfCounters* counters; // what a counted run fills in, nullptr otherwise
+    RunBudget* budget;      // stops the run when spent, nullptr for no limit
+    int t_cs, t_slc;
+    sim_time elapsed_time;
     double cpu_util, cpu_wait, io_wait, tot_wait, cpu_turn, io_turn, tot_turn, cpu_bursts_in_slice, io_bursts_in_slice, total_in_slice;
     int num_cpu_switches, num_io_switches, cpu_preempt, io_preempt;
-    // helper function to get the end-of-line queue status updates
-    std::string get_queue_status();
-    // helper function to make our outputting to cout easier
-    void print_line(const std::string& message) {
-        std::cout << "time " << elapsed_time << "ms: " << message << " " << get_queue_status() << std::endl;
+    // records an event stamped with the current time, along with the ready queue as it stands
+    EventRecord& log_event(EventKind kind, int p = -1, int a = 0, int b = 0) {
+        return log.record(elapsed_time, kind, p, a, b, q.begin(), q.end());
+    }
+    int bursts_left(int p) const {
+        return workload.num_bursts(p) - state[p].cursor;
     }
-    static bool compare_by_arrival_time(const Process& a, const Process& b) {
-        return a.arrival_time < b.arrival_time;
+    // moves the process on to its next burst
+    void pop_burst(int p) {
+        state[p].cursor++;
+        state[p].remaining = bursts_left(p) > 0 ? workload.burst(p, state[p].cursor) : 0;
     }
 };
 
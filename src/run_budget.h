@@ -0,0 +1,35 @@
+#ifndef OPSYSPROJ_RUN_BUDGET_H
+#define OPSYSPROJ_RUN_BUDGET_H
+
+#include <chrono>
+
+/*
+ * A wall-clock deadline a run gives up at, for callers that would rather have no answer than
+ * a late one. The event loops call spent() once per pass and stop when it says so; the clock is
+ * only read every CHECK_EVERY passes, so a budgeted run costs about as much as one without.
+ * The statistics of a run that gave up are meaningless, check was_exceeded() before using them.
+ */
+class RunBudget {
+public:
+    typedef std::chrono::steady_clock clock;
+    static const int CHECK_EVERY = 1024;
+
+    explicit RunBudget(clock::time_point deadline) : deadline(deadline), passes(0), exceeded(false) {}
+
+    // true once the deadline has passed, and from then on
+    bool spent() {
+        if (!exceeded && ++passes % CHECK_EVERY == 0) {
+            exceeded = clock::now() >= deadline;
+        }
+        return exceeded;
+    }
+    // whether a run stopped early because of this budget
+    bool was_exceeded() const { return exceeded; }
+
+private:
+    clock::time_point deadline;
+    long long passes;
+    bool exceeded;
+};
+
+#endif //OPSYSPROJ_RUN_BUDGET_H
@@ -0,0 +1,301 @@
+#include "server.h"
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "generator.h"
+#include "run_budget.h"
+#include "simulate.h"
+
+const int SimulationServer::DEFAULT_WORKLOADS;
+const int SimulationServer::MAX_PROCESSES;
+const int SimulationServer::MAX_CONNECTIONS;
+
+ThreadPool::ThreadPool(int threads) : stopping(false) {
+    for (int t = 0; t < (threads > 0 ? threads : 1); ++t) {
+        workers.push_back(std::thread(&ThreadPool::work, this));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+}
+
+void ThreadPool::submit(const std::function<void()>& job) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        jobs.push(job);
+    }
+    ready.notify_one();
+}
+
+void ThreadPool::work() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while (jobs.empty() && !stopping) {
+                ready.wait(guard);
+            }
+            if (jobs.empty()) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+bool WorkloadSpec::operator<(const WorkloadSpec& other) const {
+    if (n != other.n) {
+        return n < other.n;
+    }
+    if (ncpu != other.ncpu) {
+        return ncpu < other.ncpu;
+    }
+    if (seed != other.seed) {
+        return seed < other.seed;
+    }
+    if (lambda != other.lambda) {
+        return lambda < other.lambda;
+    }
+    return bound < other.bound;
+}
+
+std::shared_ptr<const Workload> WorkloadStore::get(const WorkloadSpec& spec) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::map<WorkloadSpec, Entries::iterator>::iterator found = index.find(spec);
+        if (found != index.end()) {
+            entries.splice(entries.begin(), entries, found->second);
+            return found->second->second;
+        }
+    }
+    // generated outside the lock so one big workload does not hold up every other request;
+    // two requests racing for the same spec both generate it and the second copy is dropped
+    RandomGenerator rng(spec.seed);
+    std::shared_ptr<const Workload> workload =
+            std::make_shared<Workload>(generate_processes(rng, spec.n, spec.ncpu, spec.lambda, spec.bound));
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::map<WorkloadSpec, Entries::iterator>::iterator found = index.find(spec);
+    if (found != index.end()) {
+        return found->second->second;
+    }
+    entries.push_front(std::make_pair(spec, workload));
+    index[spec] = entries.begin();
+    if (entries.size() > capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    return workload;
+}
+
+SimulationServer::SimulationServer(const std::string& path, int threads, size_t workloads)
+        : path(path), pool(threads), store(workloads), connections(0) {}
+
+// the policy a request names, false if it names none
+static bool parse_policy(const std::string& name, Policy& policy) {
+    static const char* const names[NUM_POLICIES] = {"fcfs", "sjf", "srt", "rr", "o1"};
+    for (int p = 0; p < NUM_POLICIES; ++p) {
+        if (name == names[p]) {
+            policy = (Policy) p;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string SimulationServer::handle(const std::string& request) {
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point received = clock::now();
+
+    std::istringstream in(request);
+    std::string command, name;
+    WorkloadSpec spec;
+    SimParams params;
+    long budget_ms = 0;
+    in >> command;
+    if (command != "simulate") {
+        return "error unknown command \"" + command + "\"\n";
+    }
+    in >> name >> spec.n >> spec.ncpu >> spec.seed >> spec.lambda >> spec.bound >> params.t_cs >> params.alpha
+       >> params.t_slice;
+    Policy policy;
+    const std::string usage =
+            "error usage: simulate fcfs|sjf|srt|rr|o1 n ncpu seed lambda bound t_cs alpha t_slice [budget_ms]\n";
+    if (!in || !parse_policy(name, policy)) {
+        return usage;
+    }
+    // the budget is optional, but whatever follows t_slice has to be one and nothing else
+    std::string token;
+    if (in >> token) {
+        std::istringstream number(token);
+        char trailing;
+        if (!(number >> budget_ms) || number >> trailing || in >> token) {
+            return usage;
+        }
+    }
+    if (spec.n <= 0 || spec.n > MAX_PROCESSES || spec.ncpu < 0 || spec.ncpu > spec.n || spec.bound <= 0 ||
+        params.t_cs < 0 || params.t_slice <= 0 || !std::isfinite(params.alpha) || budget_ms < 0) {
+        return "error arguments out of range\n";
+    }
+    // draws over bound are drawn again, so a mean far past it would keep the generator drawing
+    // practically forever; with 1 / lambda within bound most draws are kept
+    if (!std::isfinite(spec.lambda) || spec.lambda <= 0 || std::ceil(1 / spec.lambda) > spec.bound) {
+        return "error lambda must be positive with ceil(1 / lambda) at most bound\n";
+    }
+    params.lambda = spec.lambda;
+
+    // what the request gets, worked out on a pool thread
+    std::function<std::string()> respond = [&]() -> std::string {
+        long waited = (long) std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - received).count();
+        if (budget_ms > 0 && waited >= budget_ms) {
+            return "error budget of " + std::to_string(budget_ms) + " ms used up after " + std::to_string(waited) +
+                   " ms in the queue\n";
+        }
+        // the rest of the budget is the run's: the event loop stops once it is spent
+        RunBudget budget(received + std::chrono::milliseconds(budget_ms));
+        SimParams run = params;
+        run.budget = budget_ms > 0 ? &budget : nullptr;
+        std::shared_ptr<const Workload> workload = store.get(spec);
+        SimStats stats = simulate(*workload, policy, run);
+        if (budget.was_exceeded()) {
+            long spent = (long) std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - received).count();
+            return "error budget of " + std::to_string(budget_ms) + " ms used up after " + std::to_string(spent) +
+                   " ms, the simulation was stopped\n";
+        }
+        std::ostringstream block;
+        write_statistics_block(policy, stats, block);
+        return "ok " + std::to_string(block.str().size()) + "\n" + block.str();
+    };
+
+    // the simulation runs on the pool; this thread only waits for it. Whatever the job throws
+    // becomes the answer, since an exception leaving a worker thread would end the whole server
+    std::promise<std::string> answer;
+    std::future<std::string> result = answer.get_future();
+    pool.submit([&]() {
+        try {
+            answer.set_value(respond());
+        } catch (const std::exception& e) {
+            answer.set_value(std::string("error simulation failed: ") + e.what() + "\n");
+        } catch (...) {
+            answer.set_value("error simulation failed\n");
+        }
+    });
+    return result.get();
+}
+
+// writes all of text, false if the client went away
+static bool send_all(int fd, const std::string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t put = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return false;
+        }
+        sent += put;
+    }
+    return true;
+}
+
+void SimulationServer::connection(int fd) {
+    std::string pending;
+    char buffer[4096];
+    for (;;) {
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            if (!line.empty() && line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            if (!line.empty() && !send_all(fd, handle(line))) {
+                close(fd);
+                return;
+            }
+        }
+        ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        pending.append(buffer, got);
+    }
+    close(fd);
+}
+
+bool SimulationServer::serve(std::string& error) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "socket path " + path + " is too long";
+        return false;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    // a socket file left behind by an earlier server would make bind fail; anything else at
+    // the path is somebody's file and is left alone
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            error = path + " exists and is not a socket";
+            close(listener);
+            return false;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        error = path + ": " + std::strerror(errno);
+        close(listener);
+        return false;
+    }
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            error = std::string("accept: ") + std::strerror(errno);
+            close(listener);
+            return false;
+        }
+        // each connection holds a thread, so past MAX_CONNECTIONS new ones are turned away
+        if (connections >= MAX_CONNECTIONS) {
+            send_all(fd, "error too many connections\n");
+            close(fd);
+            continue;
+        }
+        // connection threads only read and write, the simulating happens on the pool
+        connections++;
+        std::thread([this, fd]() {
+            connection(fd);
+            connections--;
+        }).detach();
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef OPSYSPROJ_SERVER_H
+#define OPSYSPROJ_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "workload.h"
+
+// fixed set of worker threads running submitted jobs in order
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    // finishes the queued jobs, then joins the workers
+    ~ThreadPool();
+
+    void submit(const std::function<void()>& job);
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()> > jobs;
+    std::mutex lock;
+    std::condition_variable ready;
+    bool stopping;
+
+    void work();
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+// the generator parameters a workload is fully determined by
+struct WorkloadSpec {
+    int n, ncpu, seed;
+    double lambda;
+    int bound;
+
+    bool operator<(const WorkloadSpec& other) const;
+};
+
+/*
+ * Generated workloads kept in memory across requests, the least recently used one dropped
+ * once capacity are held. Workloads are immutable and handed out as shared pointers, so a
+ * request keeps its workload alive even if it is evicted meanwhile.
+ */
+class WorkloadStore {
+public:
+    explicit WorkloadStore(size_t capacity) : capacity(capacity) {}
+
+    std::shared_ptr<const Workload> get(const WorkloadSpec& spec);
+
+private:
+    typedef std::list<std::pair<WorkloadSpec, std::shared_ptr<const Workload> > > Entries;
+
+    size_t capacity;
+    std::mutex lock;
+    Entries entries; // most recently used first
+    std::map<WorkloadSpec, Entries::iterator> index;
+};
+
+/*
+ * Simulation server on a Unix domain socket, so a client asking many small what-if questions
+ * pays neither process startup nor workload generation per question.
+ *
+ * Each connection sends requests one line at a time and gets one response per request:
+ *
+ *      simulate POLICY n ncpu seed lambda bound t_cs alpha t_slice [budget_ms]
+ *
+ * POLICY is fcfs, sjf, srt, rr or o1, the rest are MAIN's arguments. The answer is
+ * "ok LENGTH\n" followed by LENGTH bytes of the statistics block MAIN would append to
+ * simout.txt, or "error MESSAGE\n". Simulations run on a pool of worker threads, so requests
+ * from different connections are served concurrently; a connection's own requests are answered
+ * in order. budget_ms counts from when the request is read: a request still queued when it runs
+ * out is answered with an error instead of being run, and a simulation that outlasts it is
+ * stopped and answered with an error too. A request with anything but a number after t_slice,
+ * with n over MAX_PROCESSES, or with a lambda whose mean 1 / lambda does not fit in bound, is
+ * answered with an error, and so is a request whose simulation throws. At most MAX_CONNECTIONS
+ * connections are open at once.
+ */
+class SimulationServer {
+public:
+    static const int DEFAULT_WORKLOADS = 64;
+    // the largest n a request may ask for, so one request cannot take all of a shared server's memory
+    static const int MAX_PROCESSES = 100000;
+    // connections served at once; one more is told "error too many connections" and closed
+    static const int MAX_CONNECTIONS = 64;
+
+    SimulationServer(const std::string& path, int threads, size_t workloads = DEFAULT_WORKLOADS);
+
+    // listens until the process is killed; returns false, with the reason in error, if it cannot listen at all
+    bool serve(std::string& error);
+
+    // the response to one request line
+    std::string handle(const std::string& request);
+
+private:
+    std::string path;
+    ThreadPool pool;
+    WorkloadStore store;
+    std::atomic<int> connections; // open right now, each on a thread of its own
+
+    void connection(int fd);
+};
+
+#endif //OPSYSPROJ_SERVER_H
@@ -0,0 +1,205 @@
+#include "shard.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const char SHARD_MAGIC[8] = {'O', 'S', 'P', 'S', 'H', 'R', 'D', '1'};
+
+// what identifies the study a shard belongs to, written at the top of every file
+struct ShardHeader {
+    ExperimentConfig config;
+    long long first_seed;
+    int32_t replications;
+    int32_t antithetic;
+    int32_t index;
+    int32_t count;
+    int32_t entries;
+};
+
+template <class T>
+void put(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+void get(std::istream& in, T& value, const std::string& filename) {
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+        throw std::runtime_error(filename + " is truncated");
+    }
+}
+
+void put_header(std::ostream& out, const ShardHeader& h) {
+    out.write(SHARD_MAGIC, sizeof(SHARD_MAGIC));
+    put(out, h.config.n);
+    put(out, h.config.ncpu);
+    put(out, h.config.lambda);
+    put(out, h.config.bound);
+    put(out, h.config.t_cs);
+    put(out, h.config.alpha);
+    put(out, h.config.t_slice);
+    put(out, h.first_seed);
+    put(out, h.replications);
+    put(out, h.antithetic);
+    put(out, h.index);
+    put(out, h.count);
+    put(out, h.entries);
+}
+
+void get_header(std::istream& in, ShardHeader& h, const std::string& filename) {
+    char magic[sizeof(SHARD_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, SHARD_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error(filename + " is not a shard file");
+    }
+    get(in, h.config.n, filename);
+    get(in, h.config.ncpu, filename);
+    get(in, h.config.lambda, filename);
+    get(in, h.config.bound, filename);
+    get(in, h.config.t_cs, filename);
+    get(in, h.config.alpha, filename);
+    get(in, h.config.t_slice, filename);
+    get(in, h.first_seed, filename);
+    get(in, h.replications, filename);
+    get(in, h.antithetic, filename);
+    get(in, h.index, filename);
+    get(in, h.count, filename);
+    get(in, h.entries, filename);
+}
+
+// whether two shard headers come from the same study
+bool same_study(const ShardHeader& a, const ShardHeader& b) {
+    return a.config.n == b.config.n && a.config.ncpu == b.config.ncpu && a.config.lambda == b.config.lambda &&
+           a.config.bound == b.config.bound && a.config.t_cs == b.config.t_cs && a.config.alpha == b.config.alpha &&
+           a.config.t_slice == b.config.t_slice && a.first_seed == b.first_seed &&
+           a.replications == b.replications && a.antithetic == b.antithetic && a.count == b.count;
+}
+
+}
+
+bool parse_shard(const std::string& text, ShardSpec& shard) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    try {
+        size_t used_i, used_k;
+        shard.index = std::stoi(text.substr(0, slash), &used_i);
+        shard.count = std::stoi(text.substr(slash + 1), &used_k);
+        if (used_i != slash || used_k != text.size() - slash - 1) {
+            return false;
+        }
+    } catch (std::exception& e) {
+        return false;
+    }
+    return shard.count > 0 && shard.index >= 0 && shard.index < shard.count;
+}
+
+std::string shard_filename(const ShardSpec& shard) {
+    return "shard-" + std::to_string(shard.index) + "-of-" + std::to_string(shard.count) + ".part";
+}
+
+void run_shard(const ExperimentConfig& config, long first_seed, int replications, bool antithetic,
+               const ShardSpec& shard, const std::string& filename) {
+    ShardHeader header;
+    header.config = config;
+    header.first_seed = first_seed;
+    header.replications = replications;
+    header.antithetic = antithetic;
+    header.index = shard.index;
+    header.count = shard.count;
+    header.entries = replications > shard.index ? (replications - shard.index + shard.count - 1) / shard.count : 0;
+
+    const std::string partial = filename + ".tmp";
+    std::ofstream out(partial.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("cannot write " + partial);
+    }
+    put_header(out, header);
+    for (int r = shard.index; r < replications; r += shard.count) {
+        Observation observation = run_replication(config, first_seed + r, antithetic);
+        put(out, (int32_t) r);
+        put(out, observation.value);
+    }
+    out.close();
+    if (!out || std::rename(partial.c_str(), filename.c_str()) != 0) {
+        std::remove(partial.c_str());
+        throw std::runtime_error("cannot write " + filename);
+    }
+}
+
+void merge_shards(const std::vector<std::string>& filenames, std::ostream& report) {
+    if (filenames.empty()) {
+        throw std::runtime_error("no shard files to merge");
+    }
+    ShardHeader study;
+    std::vector<std::string> shard_file;  // which file each shard index came from
+    std::vector<std::pair<int, Observation> > results;
+    for (size_t f = 0; f < filenames.size(); ++f) {
+        const std::string& filename = filenames[f];
+        std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot read " + filename);
+        }
+        ShardHeader header;
+        get_header(in, header, filename);
+        if (f == 0) {
+            study = header;
+            shard_file.assign(header.count > 0 ? header.count : 0, "");
+        } else if (!same_study(study, header)) {
+            throw std::runtime_error(filename + " is a shard of a different study than " + filenames[0]);
+        }
+        if (header.index < 0 || header.index >= header.count) {
+            throw std::runtime_error(filename + " has shard index " + std::to_string(header.index) + " of " +
+                                     std::to_string(header.count));
+        }
+        if (!shard_file[header.index].empty()) {
+            throw std::runtime_error("shard " + std::to_string(header.index) + " is in both " +
+                                     shard_file[header.index] + " and " + filename);
+        }
+        shard_file[header.index] = filename;
+        for (int e = 0; e < header.entries; ++e) {
+            int32_t r;
+            Observation observation;
+            get(in, r, filename);
+            get(in, observation.value, filename);
+            if (r < 0 || r >= header.replications || r % header.count != header.index) {
+                throw std::runtime_error(filename + " holds replication " + std::to_string(r) +
+                                         ", which is not part of its shard");
+            }
+            results.push_back(std::make_pair((int) r, observation));
+        }
+    }
+    for (int i = 0; i < study.count; ++i) {
+        if (shard_file[i].empty()) {
+            throw std::runtime_error("shard " + std::to_string(i) + " of " + std::to_string(study.count) +
+                                     " is missing");
+        }
+    }
+
+    // every replication once, in seed order
+    std::vector<int> seen(study.replications, 0);
+    for (size_t k = 0; k < results.size(); ++k) {
+        if (seen[results[k].first]++) {
+            throw std::runtime_error("replication " + std::to_string(results[k].first) + " appears twice");
+        }
+    }
+    for (int r = 0; r < study.replications; ++r) {
+        if (!seen[r]) {
+            throw std::runtime_error("replication " + std::to_string(r) + " is missing");
+        }
+    }
+    std::vector<const Observation*> by_replication(study.replications);
+    for (size_t k = 0; k < results.size(); ++k) {
+        by_replication[results[k].first] = &results[k].second;
+    }
+
+    ReplicationStudy merged(study.config, (long) study.first_seed, study.antithetic != 0);
+    for (int r = 0; r < study.replications; ++r) {
+        merged.add(*by_replication[r]);
+    }
+    merged.write_report(report);
+}
@@ -0,0 +1,42 @@
+#ifndef OPSYSPROJ_SHARD_H
+#define OPSYSPROJ_SHARD_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "replication.h"
+
+/*
+ * Splitting a replication study across processes, or machines sharing a filesystem.
+ *
+ * Replication r of a study runs the seed first_seed + r, and shard i of k takes every r with
+ * r % k == i, so the k shards partition the study without talking to each other and every
+ * shard costs about the same. A shard writes what it measured to a partial-results file;
+ * merge_shards() reads the k files back, checks they are the shards of one study with each
+ * replication present exactly once, and reports the whole study as if it had run in one go.
+ *
+ * A partial-results file is binary, in host byte order:
+ *      "OSPSHRD1", the ExperimentConfig fields, first seed, replications in the whole study,
+ *      antithetic flag, shard index, shard count, replications in this shard, then for each of
+ *      them its index r and the NUM_POLICIES x NUM_METRICS values of its Observation.
+ * It is written under a temporary name and renamed into place, so a file that exists is complete.
+ */
+struct ShardSpec {
+    int index;
+    int count;
+};
+
+// parses "i/k", with 0 <= i < k
+bool parse_shard(const std::string& text, ShardSpec& shard);
+// the file shard writes into the current directory, e.g. "shard-2-of-8.part"
+std::string shard_filename(const ShardSpec& shard);
+
+// runs shard's replications of the study and writes them to filename; throws std::runtime_error if it cannot
+void run_shard(const ExperimentConfig& config, long first_seed, int replications, bool antithetic,
+               const ShardSpec& shard, const std::string& filename);
+
+// merges the shard files into one study and writes its report; throws std::runtime_error naming
+// the problem when a file is unreadable, belongs to another study, or replications are missing or duplicated
+void merge_shards(const std::vector<std::string>& filenames, std::ostream& report);
+
+#endif //OPSYSPROJ_SHARD_H
@@ -0,0 +1,20 @@
+#ifndef OPSYSPROJ_SIM_STATS_H
+#define OPSYSPROJ_SIM_STATS_H
+
+// the per-algorithm numbers written to simout.txt
+struct SimStats {
+    double cpu_util;
+    double cpu_wait, io_wait, tot_wait;
+    double cpu_turn, io_turn, tot_turn;
+    int num_cpu_switches, num_io_switches;
+    int cpu_preempt, io_preempt;
+    // RR only: fraction of CPU bursts that finished within one time slice
+    double cpu_in_slice, io_in_slice, tot_in_slice;
+
+    SimStats()
+            : cpu_util(0.0), cpu_wait(0.0), io_wait(0.0), tot_wait(0.0), cpu_turn(0.0), io_turn(0.0), tot_turn(0.0),
+              num_cpu_switches(0), num_io_switches(0), cpu_preempt(0), io_preempt(0),
+              cpu_in_slice(0.0), io_in_slice(0.0), tot_in_slice(0.0) {}
+};
+
+#endif //OPSYSPROJ_SIM_STATS_H
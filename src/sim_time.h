@@ -0,0 +1,19 @@
+#ifndef OPSYSPROJ_SIM_TIME_H
+#define OPSYSPROJ_SIM_TIME_H
+
+/*
+ * Simulated time in ms, as kept by the event loops, the I/O queues and the trace.
+ *
+ * A run of a few million processes goes past 2^31 ms, where an int clock wraps and the
+ * statistics come out as nonsense, so time is 64-bit by default. Bursts and arrivals stay
+ * int: each of them is bounded by the generator's upper bound, only sums of them grow.
+ * Configuring with -DOPSYS_TIME32=ON (OPSYSPROJ_TIME32) builds a 32-bit clock for anyone
+ * who wants to compare; on x86-64 the two run at the same speed.
+ */
+#ifdef OPSYSPROJ_TIME32
+typedef int sim_time;
+#else
+typedef long long sim_time;
+#endif
+
+#endif //OPSYSPROJ_SIM_TIME_H
@@ -0,0 +1,89 @@
+#include "simulate.h"
+#include "fcfs.h"
+#include "fcfs_fast.h"
+#include "sjf.h"
+#include "srt.h"
+#include "rr.h"
+#include "prio.h"
+#include "perf_counters.h"
+
+const char* policy_name(Policy policy) {
+    static const char* const names[NUM_POLICIES] = {"FCFS", "SJF", "SRT", "RR", "O(1)"};
+    return names[policy];
+}
+
+// hands a finished scheduler's events to the sink, if it is recording them; for a counted run
+// the time on watch so far was the simulation, what follows is output
+template <class Scheduler>
+static SimStats finish(const Workload& workload, const Scheduler& scheduler, OutputSink* events,
+                       PerfCounters* counters, Stopwatch& watch) {
+    if (counters != nullptr) {
+        counters->simulate_seconds = watch.lap();
+    }
+    if (events != nullptr) {
+        events->events(workload, scheduler.events());
+    }
+    return scheduler.statistics();
+}
+
+// points the scheduler's log at the sink's drain, if the sink takes the trace while it is recorded
+template <class Scheduler>
+static Scheduler& draining(Scheduler& scheduler, const Workload& workload, OutputSink* events) {
+    if (events != nullptr) {
+        scheduler.events().set_drain(events->event_drain(workload));
+    }
+    return scheduler;
+}
+
+// runs policy; events is the sink when the run is traced, else nullptr
+static SimStats run(const Workload& workload, Policy policy, const SimParams& params, TraceLevel level,
+                    OutputSink* events, Stopwatch& watch) {
+    PerfCounters* counters = params.counters;
+
+    switch (policy) {
+        case POLICY_FCFS: {
+            // the fast path has no event loop to count, so a counted run takes the simulator
+            if (level == TRACE_OFF && counters == nullptr) {
+                return fcfs_fast_statistics(workload, params.t_cs, nullptr, params.budget);
+            }
+            fcfs scheduler(workload, params.t_cs);
+            draining(scheduler, workload, events).simulate(level, params.filter, counters, params.budget);
+            return finish(workload, scheduler, events, counters, watch);
+        }
+        case POLICY_SJF: {
+            sjf scheduler(workload, params.t_cs, params.alpha, params.lambda);
+            draining(scheduler, workload, events).simulate(level, params.filter, counters, params.budget);
+            return finish(workload, scheduler, events, counters, watch);
+        }
+        case POLICY_SRT: {
+            srt scheduler(workload, params.t_cs, params.alpha, params.lambda);
+            draining(scheduler, workload, events).simulate(level, params.filter, counters, params.budget);
+            return finish(workload, scheduler, events, counters, watch);
+        }
+        case POLICY_RR: {
+            rr scheduler(workload, params.t_cs, params.t_slice);
+            draining(scheduler, workload, events).simulate(level, params.filter, counters, params.budget);
+            return finish(workload, scheduler, events, counters, watch);
+        }
+        case POLICY_PRIO: {
+            prio scheduler(workload, params.t_cs, params.t_slice);
+            draining(scheduler, workload, events).simulate(level, params.filter, counters, params.budget);
+            return finish(workload, scheduler, events, counters, watch);
+        }
+        default:
+            return SimStats();
+    }
+}
+
+SimStats simulate(const Workload& workload, Policy policy, const SimParams& params, OutputSink* sink) {
+    const TraceLevel level = sink != nullptr && sink->wants_events() ? params.trace : TRACE_OFF;
+    Stopwatch watch;
+    SimStats stats = run(workload, policy, params, level, level != TRACE_OFF ? sink : nullptr, watch);
+    if (sink != nullptr) {
+        sink->statistics(policy, stats);
+    }
+    if (params.counters != nullptr) {
+        params.counters->output_seconds = watch.lap();
+    }
+    return stats;
+}
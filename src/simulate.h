@@ -0,0 +1,50 @@
+#ifndef OPSYSPROJ_SIMULATE_H
+#define OPSYSPROJ_SIMULATE_H
+
+#include "workload.h"
+#include "sim_stats.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "policy.h"
+#include "output_sink.h"
+
+struct PerfCounters;
+class RunBudget;
+
+/*
+ * The one call an embedding program needs: run a scheduler over a workload and get its
+ * statistics back. Anything else the run produces goes to the OutputSink it is given (see
+ * output_sink.h), never straight to std::cout or a file.
+ *
+ * simulate() is reentrant. Everything a run writes (the scheduler, its arena, its event log)
+ * lives inside the call, and the workload and filter are only read, so any number of
+ * simulations may run at once on different threads, sharing one Workload between them.
+ * Sinks, PerfCounters and RunBudgets are not synchronised, each thread needs its own.
+ */
+
+// what a run is parameterised by, fields a policy does not read are ignored
+struct SimParams {
+    int t_cs;                  // context switch time, ms
+    double alpha;              // SJF, SRT: exponential averaging constant
+    double lambda;             // SJF, SRT: every process starts with tau = 1 / lambda
+    int t_slice;               // RR, O(1): time slice, ms
+    TraceLevel trace;          // what is recorded for the sink, only matters when it wants_events()
+    const TraceFilter* filter; // narrows what is recorded, nullptr for everything
+    PerfCounters* counters;    // filled in with what the run did (see perf_counters.h), nullptr to not count
+    RunBudget* budget;         // the run stops once it is spent (see run_budget.h), nullptr for no limit
+
+    SimParams()
+            : t_cs(0), alpha(0), lambda(0), t_slice(0), trace(TRACE_CUTOFF), filter(nullptr), counters(nullptr),
+              budget(nullptr) {}
+};
+
+/*
+ * Runs policy over workload and hands the run to sink: its events, if the sink wants_events()
+ * and params.trace is not TRACE_OFF, then its statistics. When nothing is recorded or counted
+ * FCFS takes the trace-free fast path (see fcfs_fast.h). With params.counters set they get the
+ * run's counters and its time simulating and handing the run to the sink. With params.budget
+ * set, a run that outlasts it stops early and hands the sink whatever it had.
+ */
+SimStats simulate(const Workload& workload, Policy policy, const SimParams& params, OutputSink* sink = nullptr);
+
+#endif //OPSYSPROJ_SIMULATE_H
@@ -1,11 +1,12 @@
 #include "sjf.h"
+#include "perf_counters.h"
+#include "run_budget.h"
 #include <iostream>
 #include <queue>
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
 #include <map>
-#include <fstream>
 
 // Helper function to calculate the new tau
 double sjf::calculate_new_tau(double old_tau, int actual_burst, double alpha, double lambda) {
@@ -13,81 +14,70 @@ double sjf::calculate_new_tau(double old_tau, int actual_burst, double alpha, do
 }
 
 // Function to compare tau values
-bool sjf::CompareTau(const Process &a, const Process &b) {
-    if (a.tau == b.tau) {
-        return a.id < b.id;  // Tie-breaking by process ID
+bool sjf::CompareTau::operator()(int a, int b) const {
+    if (s->state[a].tau == s->state[b].tau) {
+        return s->state[a].id_rank < s->state[b].id_rank;  // Tie-breaking by process ID
     }
-    return a.tau < b.tau;
+    return s->state[a].tau < s->state[b].tau;
 }
 
 // sjf constructor definition
-sjf::sjf(std::vector<Process> processes, int context_time, double alpha, double lambda)
-        : processes(processes), context_time(context_time), alpha(alpha), lambda(lambda), elapsed_time(0),
+sjf::sjf(const Workload& workload, int context_time, double alpha, double lambda)
+        : workload(workload), state(workload.initial_state(std::ceil(1 / lambda))), ready_queue(ArenaAllocator<int>(&arena)), log("SJF"), counters(nullptr), budget(nullptr), context_time(context_time), alpha(alpha), lambda(lambda), elapsed_time(0),
           total_cpu_time(0), cpu_bound_wait_time(0), io_bound_wait_time(0),
           cpu_bound_turnaround_time(0), io_bound_turnaround_time(0),
           cpu_bound_context_switches(0), io_bound_context_switches(0),
           cpu_preempt(0), io_preempt(0), cpu_util(0.0), cpu_turn(0.0), io_turn(0.0), cpu_wait(0.0), io_wait(0.0),
           num_cpu_switches(0), num_io_switches(0) {
-    // Initial tau setup for each process
-    for (size_t i = 0; i < this->processes.size(); ++i) {
-        this->processes[i].tau = std::ceil(1 / lambda);  // Initial tau value based on lambda
-    }
-}
-
-// print_event function definition
-void sjf::print_event(int time, const std::string &event, const std::vector<Process> &ready_queue) {
-    std::cout << "time " << time << "ms: " << event << " [Q";
-    if (ready_queue.empty()) {
-        std::cout << " empty";
-    } else {
-        for (size_t i = 0; i < ready_queue.size(); ++i) {
-            std::cout << " " << ready_queue[i].id;
-        }
-    }
-    std::cout << "]" << std::endl;
-}
-
-// Function to check if a process has a specific ID
-bool sjf::processHasId(const Process& p, const std::string& id) {
-    return p.id == id;
-}
-// Define the comparison function
-bool sjf::compare_by_arrival_time(const Process& a, const Process& b) {
-    return a.arrival_time < b.arrival_time;
 }
 
-
 // The simulate function implementation, including tau recalculation and event handling
-void sjf::simulate() {
-    std::sort(processes.begin(), processes.end(), compare_by_arrival_time);
+template <class Trace>
+void sjf::run() {
+    const int n = workload.size();
 
-    print_event(0, "Simulator started for SJF", ready_queue);
-    std::map<int, Process> io_bound_map;
-    std::priority_queue<int, std::vector<int>, std::greater<int> > io_bound_map_keys;
+    if (Trace::counted) {
+        counters->handled(EV_SIM_START);
+    }
+    if (Trace::enabled) {
+        log_event(0, EV_SIM_START);
+    }
+    // (completion time, process) of everyone blocked on I/O, a map keyed on time alone lost
+    // one of two processes finishing I/O at the same millisecond
+    arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > > io_queue =
+            make_arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > >(arena);
     bool cpu_free = true;
     int i = 0;
-    Process using_cpu;
-    int time_cpu_frees = -1;
+    int using_cpu = -1;
+    sim_time time_cpu_frees = -1;
     int processes_killed = 0;
 
-    while (processes_killed < (int) processes.size()) {
+    while (processes_killed < n) {
         bool did_something = false;
+        if (Trace::counted) {
+            counters->iterations++;
+        }
+        if (budget != nullptr && budget->spent()) {
+            break;  // out of time, the caller throws the statistics away
+        }
 
         // Add any arriving processes to the ready queue
-        if (i < (int) processes.size()) {
-            int curr_arrival = processes[i].arrival_time;
-            if (curr_arrival >= elapsed_time &&
-                (time_cpu_frees == -1 || curr_arrival <= time_cpu_frees) &&
-                (io_bound_map_keys.empty() || curr_arrival <= io_bound_map_keys.top())) {
-
-                processes[i].tau = std::ceil(1 / lambda);  // Initial tau value based on lambda
-                ready_queue.push_back(processes[i]);
-                elapsed_time = processes[i].arrival_time;
-
-                std::sort(ready_queue.begin(), ready_queue.end(), CompareTau);
-
-                if (elapsed_time <= 9999) {
-                    print_event(elapsed_time, "Process " + processes[i].id + " (tau " + std::to_string(static_cast<int>(std::round(processes[i].tau))) + "ms) arrived; added to ready queue", ready_queue);
+        if (i < n) {
+            int curr_arrival = workload.arrival_time(i);
+            // an arrival that fell inside a switch-out is still let in, it used to be skipped for good
+            if ((time_cpu_frees == -1 || curr_arrival <= time_cpu_frees) &&
+                (io_queue.empty() || curr_arrival <= io_queue.top().first)) {
+
+                state[i].tau = std::ceil(1 / lambda);  // Initial tau value based on lambda
+                insert_ready(i);
+                elapsed_time = workload.arrival_time(i);
+
+                if (Trace::counted) {
+                    counters->ready_pushed(ready_queue.size());
+                    counters->handled(EV_ARRIVAL);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(elapsed_time, EV_ARRIVAL, i).with_tau(static_cast<int>(std::round(state[i].tau)));
                 }
                 i++;
                 did_something = true;
@@ -99,12 +89,16 @@ void sjf::simulate() {
             cpu_free = false;
             elapsed_time += context_time / 2;
             using_cpu = ready_queue.front();
-            int burst = using_cpu.bursts.front();  // Assign the first burst time
+            int burst = front_burst(using_cpu);  // Assign the first burst time
             time_cpu_frees = burst + elapsed_time;
             ready_queue.erase(ready_queue.begin());
+            if (Trace::counted) {
+                counters->ready_popped();
+                counters->handled(EV_CPU_START);
+            }
 
-            int wait_time = elapsed_time - using_cpu.arrival_time - (context_time / 2);  // Calculate the wait time
-            if (using_cpu.is_cpu_bound) {
+            sim_time wait_time = elapsed_time - workload.arrival_time(using_cpu) - (context_time / 2);  // Calculate the wait time
+            if (state[using_cpu].cpu_bound) {
                 cpu_bound_wait_time += wait_time;
             } else {
                 io_bound_wait_time += wait_time;
@@ -112,31 +106,33 @@ void sjf::simulate() {
 
             total_cpu_time += burst;  // Track total CPU time
 
-            if (elapsed_time <= 9999) {
-                print_event(elapsed_time, "Process " + using_cpu.id + " (tau " + std::to_string(static_cast<int>(std::round(using_cpu.tau))) +
-                                          "ms) started using the CPU for " + std::to_string(burst) + "ms burst", ready_queue);
+            if (Trace::windowed(elapsed_time)) {
+                log_event(elapsed_time, EV_CPU_START, using_cpu, burst).with_tau(static_cast<int>(std::round(state[using_cpu].tau)));
             }
-            using_cpu.bursts.erase(using_cpu.bursts.begin());
+            state[using_cpu].cursor++;
             did_something = true;
         }
 
         // Handle CPU or IO events
         if (!did_something || time_cpu_frees == elapsed_time ||
-            (!io_bound_map_keys.empty() && io_bound_map_keys.top() == elapsed_time)) {
-            if (time_cpu_frees > 0 && time_cpu_frees <= (!io_bound_map_keys.empty() ? io_bound_map_keys.top() : time_cpu_frees)) {
+            (!io_queue.empty() && io_queue.top().first == elapsed_time)) {
+            if (time_cpu_frees > 0 && time_cpu_frees <= (!io_queue.empty() ? io_queue.top().first : time_cpu_frees)) {
                 elapsed_time = time_cpu_frees;
                 time_cpu_frees = -1;
                 cpu_free = true;
 
                 // Process just completed a CPU burst
-                if (elapsed_time <= 9999) {
-                    print_event(elapsed_time, "Process " + using_cpu.id + " (tau " + std::to_string(static_cast<int>(std::round(using_cpu.tau))) +
-                                              "ms) completed a CPU burst; " + std::to_string(using_cpu.bursts.size() / 2) + " bursts to go", ready_queue);
+                if (Trace::counted) {
+                    counters->handled(EV_BURST_DONE);
+                }
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(elapsed_time, EV_BURST_DONE, using_cpu, bursts_left(using_cpu) / 2)
+                            .with_tau(static_cast<int>(std::round(state[using_cpu].tau))).flags |= EVF_ALWAYS_PLURAL;
                 }
 
                 // Track turnaround time
-                int turnaround_time = elapsed_time - using_cpu.arrival_time;
-                if (using_cpu.is_cpu_bound) {
+                sim_time turnaround_time = elapsed_time - workload.arrival_time(using_cpu);
+                if (state[using_cpu].cpu_bound) {
                     cpu_bound_turnaround_time += turnaround_time;
                     cpu_bound_context_switches++;
                 } else {
@@ -145,64 +141,81 @@ void sjf::simulate() {
                 }
 
                 // Check if the process has more bursts to execute
-                if (!using_cpu.bursts.empty()) {
-                    int actual_burst = using_cpu.bursts.front();
-                    int old_tau = using_cpu.tau;
-                    using_cpu.tau = calculate_new_tau(old_tau, actual_burst, alpha, lambda);
-
-                    if (elapsed_time <= 9999) {
-                        print_event(elapsed_time, "Recalculated tau for process " + using_cpu.id + ": old tau " +
-                                                  std::to_string(static_cast<int>(std::round(old_tau))) + "ms ==> new tau " + std::to_string(static_cast<int>(std::round(using_cpu.tau))) + "ms", ready_queue);
+                if (bursts_left(using_cpu) > 0) {
+                    int actual_burst = front_burst(using_cpu);
+                    int old_tau = state[using_cpu].tau;
+                    state[using_cpu].tau = calculate_new_tau(old_tau, actual_burst, alpha, lambda);
+
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(elapsed_time, EV_TAU_RECALC, using_cpu, static_cast<int>(std::round(old_tau)),
+                                  static_cast<int>(std::round(state[using_cpu].tau)));
                     }
 
                     // Now the process moves to I/O
-                    using_cpu.bursts.erase(using_cpu.bursts.begin());
-                    int io_completion_time = elapsed_time + context_time + actual_burst;
-                    io_bound_map[io_completion_time] = using_cpu;
-                    io_bound_map_keys.push(io_completion_time);
+                    state[using_cpu].cursor++;
+                    sim_time io_completion_time = elapsed_time + context_time + actual_burst;
+                    io_queue.push(std::make_pair(io_completion_time, using_cpu));
+                    if (Trace::counted) {
+                        counters->handled(EV_TAU_RECALC);
+                        counters->handled(EV_IO_BLOCK);
+                        counters->io_pushed(io_queue.size());
+                    }
 
                     elapsed_time += context_time / 2;
 
-                    if (elapsed_time <= 9999) {
-                        print_event(elapsed_time, "Process " + using_cpu.id + " switching out of CPU; blocking on I/O until time " +
-                                                  std::to_string(io_completion_time) + "ms", ready_queue);
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(elapsed_time, EV_IO_BLOCK, using_cpu, (int) (io_completion_time - elapsed_time));
                     }
                 } else {
                     // If the process has no more bursts, it terminates
-                    print_event(elapsed_time, "Process " + using_cpu.id + " terminated", ready_queue);
+                    if (Trace::counted) {
+                        counters->handled(EV_TERMINATED);
+                    }
+                    if (Trace::enabled) {
+                        log_event(elapsed_time, EV_TERMINATED, using_cpu);
+                    }
                     processes_killed++;
-                    using_cpu = Process();  // Clear using_cpu to avoid further operations
+                    using_cpu = -1;  // Clear using_cpu to avoid further operations
                     time_cpu_frees = -1;    // Clear time_cpu_frees to avoid further processing
                 }
 
-            } else if (!io_bound_map_keys.empty() && (time_cpu_frees >= io_bound_map_keys.top() || time_cpu_frees == -1)) {
-                elapsed_time = io_bound_map_keys.top();
-                Process process_from_io = io_bound_map[elapsed_time];
-                io_bound_map.erase(elapsed_time);
-                io_bound_map_keys.pop();
+            } else if (!io_queue.empty() && (time_cpu_frees >= io_queue.top().first || time_cpu_frees == -1)) {
+                elapsed_time = io_queue.top().first;
+                int process_from_io = io_queue.top().second;
+                io_queue.pop();
 
                 // Only re-add the process to the ready queue if it hasn't terminated
                 bool found = false;
-                for (std::vector<Process>::iterator it = ready_queue.begin(); it != ready_queue.end(); ++it) {
-                    if (processHasId(*it, process_from_io.id)) {
+                for (arena_vector<int>::iterator it = ready_queue.begin(); it != ready_queue.end(); ++it) {
+                    if (*it == process_from_io) {
                         found = true;
                         break;
                     }
                 }
 
-                if (!process_from_io.bursts.empty() && !found) {
-                    ready_queue.push_back(process_from_io);
-                    std::sort(ready_queue.begin(), ready_queue.end(), CompareTau);
+                if (bursts_left(process_from_io) > 0 && !found) {
+                    insert_ready(process_from_io);
 
-                    if (elapsed_time <= 9999) {
-                        print_event(elapsed_time, "Process " + process_from_io.id + " completed I/O; added to ready queue", ready_queue);
+                    if (Trace::counted) {
+                        counters->ready_pushed(ready_queue.size());
+                        counters->handled(EV_IO_DONE);
+                    }
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(elapsed_time, EV_IO_DONE, process_from_io);
                     }
                 }
             }
         }
     }
 
-    print_event(elapsed_time, "Simulator ended for SJF", ready_queue);
+    if (Trace::enabled) {
+        log_event(elapsed_time, EV_SIM_END);
+    }
+    if (Trace::counted) {
+        counters->handled(EV_SIM_END);
+        counters->preemptions = cpu_preempt + io_preempt;
+        counters->take_memory(arena);
+    }
 
     // Update statistics after simulation
     if (elapsed_time > 0) {
@@ -220,24 +233,57 @@ void sjf::simulate() {
     num_io_switches = io_bound_context_switches;
 }
 
+// runs the event loop instantiated for the requested trace level, keeping only what filter accepts,
+// and the counted one of it when there are counters to fill in
+void sjf::simulate(TraceLevel level, const TraceFilter* filter, PerfCounters* counters, RunBudget* budget) {
+    log.set_filter(filter);
+    this->counters = counters;
+    this->budget = budget;
+    switch (level) {
+        case TRACE_OFF:
+            counters != nullptr ? run<Counted<TraceOff> >() : run<TraceOff>();
+            break;
+        case TRACE_CUTOFF:
+            counters != nullptr ? run<Counted<TraceCutoff> >() : run<TraceCutoff>();
+            break;
+        case TRACE_FULL:
+            counters != nullptr ? run<Counted<TraceFull> >() : run<TraceFull>();
+            break;
+    }
+}
+
 // Implementing the write_statistics function for SJF
-void sjf::write_statistics(const std::string& filename) const {
-    std::fstream outfile(filename, std::ios::app);
+SimStats sjf::statistics() const {
+    // a class that never ran reports zeros rather than 0 / 0
+    const bool cpu_ran = cpu_bound_context_switches > 0, io_ran = io_bound_context_switches > 0;
+    SimStats stats;
+    stats.cpu_util = cpu_util;
+    stats.cpu_wait = cpu_ran ? cpu_wait : 0;
+    stats.io_wait = io_ran ? io_wait : 0;
+    stats.tot_wait = cpu_ran && io_ran ? (cpu_wait + io_wait) / 2 : 0;
+    stats.cpu_turn = cpu_ran ? cpu_turn : 0;
+    stats.io_turn = io_ran ? io_turn : 0;
+    stats.tot_turn = cpu_ran && io_ran ? (cpu_turn + io_turn) / 2 : 0;
+    stats.num_cpu_switches = num_cpu_switches;
+    stats.num_io_switches = num_io_switches;
+    stats.cpu_preempt = cpu_preempt;
+    stats.io_preempt = io_preempt;
+    return stats;
+}
 
+void sjf::write_statistics(const SimStats& stats, std::ostream& outfile) {
     outfile << "Algorithm SJF" << std::endl;
-    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (cpu_util * 100) << "%" << std::endl;
-    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << (cpu_bound_context_switches > 0 ? cpu_wait : 0) << " ms" << std::endl;
-    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << (io_bound_context_switches > 0 ? io_wait : 0) << " ms" << std::endl;
-    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << ((cpu_bound_context_switches > 0 && io_bound_context_switches > 0) ? ((cpu_wait + io_wait) / 2) : 0) << " ms" << std::endl;
-    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << (cpu_bound_context_switches > 0 ? cpu_turn : 0) << " ms" << std::endl;
-    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << (io_bound_context_switches > 0 ? io_turn : 0) << " ms" << std::endl;
-    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << ((cpu_bound_context_switches > 0 && io_bound_context_switches > 0) ? ((cpu_turn + io_turn) / 2) : 0) << " ms" << std::endl;
-    outfile << "-- CPU-bound number of context switches: " << num_cpu_switches << std::endl;
-    outfile << "-- I/O-bound number of context switches: " << num_io_switches << std::endl;
-    outfile << "-- overall number of context switches: " << num_cpu_switches + num_io_switches << std::endl;
-    outfile << "-- CPU-bound number of preemptions: " << cpu_preempt << std::endl;
-    outfile << "-- I/O-bound number of preemptions: " << io_preempt << std::endl;
-    outfile << "-- overall number of preemptions: " << cpu_preempt + io_preempt << std::endl << std::endl;
-
-    outfile.close();
+    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (stats.cpu_util * 100) << "%" << std::endl;
+    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << stats.cpu_wait << " ms" << std::endl;
+    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << stats.io_wait << " ms" << std::endl;
+    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << stats.tot_wait << " ms" << std::endl;
+    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.cpu_turn << " ms" << std::endl;
+    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.io_turn << " ms" << std::endl;
+    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << stats.tot_turn << " ms" << std::endl;
+    outfile << "-- CPU-bound number of context switches: " << stats.num_cpu_switches << std::endl;
+    outfile << "-- I/O-bound number of context switches: " << stats.num_io_switches << std::endl;
+    outfile << "-- overall number of context switches: " << stats.num_cpu_switches + stats.num_io_switches << std::endl;
+    outfile << "-- CPU-bound number of preemptions: " << stats.cpu_preempt << std::endl;
+    outfile << "-- I/O-bound number of preemptions: " << stats.io_preempt << std::endl;
+    outfile << "-- overall number of preemptions: " << stats.cpu_preempt + stats.io_preempt << std::endl << std::endl;
 }
@@ -1,45 +1,87 @@
 #ifndef OPSYSPROJ_SJF_H
 #define OPSYSPROJ_SJF_H
 
-#include "process.h"
+#include "workload.h"
+#include "arena.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "sim_stats.h"
 #include <vector>
 #include <string>
 #include <algorithm>
 
+struct PerfCounters;
+class RunBudget;
 
 class sjf {
 public:
-    sjf(std::vector<Process> processes, int context_time, double alpha, double lambda);
+    sjf(const Workload& workload, int context_time, double alpha, double lambda);
 
-    void simulate();
+    // with counters given, the run also fills them in (see perf_counters.h); with a budget it stops
+    // once that is spent (see run_budget.h)
+    void simulate(TraceLevel level = TRACE_CUTOFF, const TraceFilter* filter = nullptr,
+                  PerfCounters* counters = nullptr, RunBudget* budget = nullptr);
 
-    void write_statistics(const std::string& filename) const;
+    SimStats statistics() const;
+    // writes the SJF block for stats to out
+    static void write_statistics(const SimStats& stats, std::ostream& out);
+
+    // the arena the engine containers allocate from, to check the event loop stays allocation-free
+    const Arena& memory() const { return arena; }
+
+    // everything the simulation traced, render() it to get the text
+    const EventLog& events() const { return log; }
+    // the same log, for handing it a drain (see EventLog::set_drain()) before simulate()
+    EventLog& events() { return log; }
 
 private:
-    std::vector<Process> processes;
-    std::vector<Process> ready_queue;  // Ready queue for SJF
+    // the event loop, instantiated once per trace policy (see trace_policy.h)
+    template <class Trace>
+    void run();
+
+    // orders handles by tau, tie-breaking by process ID
+    struct CompareTau {
+        const sjf* s;
+        explicit CompareTau(const sjf* s) : s(s) {}
+        bool operator()(int a, int b) const;
+    };
+
+    const Workload& workload;
+    std::vector<ProcState> state;  // hot per-process state (cursor, tau), indexed by handle
+    Arena arena; // everything the simulation allocates, freed when the scheduler goes away
+    arena_vector<int> ready_queue;  // Ready queue for SJF
+    EventLog log;  // trace of the run, rendered on demand
+    PerfCounters* counters;  // what a counted run fills in, nullptr otherwise
+    RunBudget* budget;       // stops the run when spent, nullptr for no limit
     int context_time;
     double alpha;  // Alpha value for tau recalculation
     double lambda; // Lambda value for tau recalculation
-    int elapsed_time;
+    sim_time elapsed_time;
 
-    int total_cpu_time;
-    int cpu_bound_wait_time, io_bound_wait_time;
-    int cpu_bound_turnaround_time, io_bound_turnaround_time;
+    // sums over every burst of the run, 64-bit whatever sim_time is
+    long long total_cpu_time;
+    long long cpu_bound_wait_time, io_bound_wait_time;
+    long long cpu_bound_turnaround_time, io_bound_turnaround_time;
     int cpu_bound_context_switches, io_bound_context_switches;
     int cpu_preempt, io_preempt;
 
     double cpu_util, cpu_turn, io_turn, cpu_wait, io_wait;
     int num_cpu_switches, num_io_switches;
 
-    static bool CompareTau(const Process &a, const Process &b);
-    static bool compare_by_arrival_time(const Process& a, const Process& b);
-
     double calculate_new_tau(double old_tau, int actual_burst, double alpha, double lambda);
+    // adds p to the ready queue in CompareTau order; a queued process's tau never changes, so
+    // the queue stays sorted and a binary search finds the place a full sort would put p
+    void insert_ready(int p) {
+        ready_queue.insert(std::upper_bound(ready_queue.begin(), ready_queue.end(), p, CompareTau(this)), p);
+    }
 
-    void print_event(int time, const std::string &event, const std::vector<Process> &ready_queue);
+    // records an event along with the ready queue as it stands
+    EventRecord& log_event(sim_time time, EventKind kind, int p = -1, int a = 0, int b = 0) {
+        return log.record(time, kind, p, a, b, ready_queue.begin(), ready_queue.end());
+    }
 
-    bool processHasId(const Process& p, const std::string& id);
+    int bursts_left(int p) const { return workload.num_bursts(p) - state[p].cursor; }
+    int front_burst(int p) const { return bursts_left(p) > 0 ? workload.burst(p, state[p].cursor) : 0; }
 };
 
 #endif // OPSYSPROJ_SJF_H
@@ -1,70 +1,83 @@
 #include "srt.h"
+#include "perf_counters.h"
+#include "run_budget.h"
 #include <cmath>
 #include <iomanip>
 #include <queue>
-#include <fstream>
 #include <algorithm>
 
 
-// Helper function to print events and queue status
-void srt::print_event(int time, const std::string &event, const std::priority_queue<Process, std::vector<Process>, CompareRemainingTime> &ready_queue) {
-    std::cout << "time " << time << "ms: " << event << " [Q";
-
-    if (ready_queue.empty()) {
-        std::cout << " empty";
-    } else {
-        std::priority_queue<Process, std::vector<Process>, CompareRemainingTime> temp_queue = ready_queue;
-        while (!temp_queue.empty()) {
-            std::cout << " " << temp_queue.top().id;
-            temp_queue.pop();
-        }
-    }
-
-    std::cout << "]" << std::endl;
+// Helper function to record events along with the queue status
+EventRecord& srt::log_event(sim_time time, EventKind kind, int p, int a, int b) {
+    // the heap itself is only partially ordered, so snapshot a sorted copy in pop order
+    queue_snapshot.assign(ready_queue.begin(), ready_queue.end());
+    std::sort_heap(queue_snapshot.begin(), queue_snapshot.end(), CompareRemainingTime(this));
+    return log.record(time, kind, p, a, b, queue_snapshot.rbegin(), queue_snapshot.rend());
 }
 
 // Helper function to calculate new tau using exponential averaging
 double srt::calculate_new_tau(double old_tau, int actual_burst, double alpha, double lambda) {
     return alpha * actual_burst + (1 - alpha) * old_tau;
 }
-bool srt::compare_by_arrival_time(const Process& a, const Process& b) {
-    return a.arrival_time < b.arrival_time;
-}
 
 
-void srt::simulate() {
-    std::sort(processes.begin(), processes.end(), compare_by_arrival_time);
-    print_event(elapsed_time, "Simulator started for SRT", ready_queue);
+template <class Trace>
+void srt::run() {
+    const int n = workload.size();
+    if (Trace::counted) {
+        counters->handled(EV_SIM_START);
+    }
+    if (Trace::enabled) {
+        log_event(elapsed_time, EV_SIM_START);
+    }
 
-    Process* current_process = nullptr;
-    int time_cpu_frees = -1;  // Time when the CPU becomes free
+    int i = 0;
+    int current_process = -1;
+    sim_time time_cpu_frees = -1;  // Time when the CPU becomes free
     int context_switch_time_remaining = 0;
 
-    int total_cpu_time = 0;
-    int cpu_bound_wait_time = 0, io_bound_wait_time = 0;
-    int cpu_bound_turnaround_time = 0, io_bound_turnaround_time = 0;
+    long long total_cpu_time = 0;
+    long long cpu_bound_wait_time = 0, io_bound_wait_time = 0;
+    long long cpu_bound_turnaround_time = 0, io_bound_turnaround_time = 0;
 
-    while (!processes.empty() || !ready_queue.empty() || current_process != nullptr || !io_bound_map_keys.empty()) {
+    while (i < n || !ready_queue.empty() || current_process != -1 || !io_queue.empty()) {
         bool did_something = false;
+        if (Trace::counted) {
+            counters->iterations++;
+        }
+        if (budget != nullptr && budget->spent()) {
+            break;  // out of time, the caller throws the statistics away
+        }
 
         // Handle arriving processes
-        while (!processes.empty() && processes.front().arrival_time <= elapsed_time) {
-            Process new_process = processes.front();
-            processes.erase(processes.begin());
+        while (i < n && workload.arrival_time(i) <= elapsed_time) {
+            int new_process = i++;
 
-            new_process.remaining_time = new_process.bursts.front();  // Set initial remaining time to the first burst length
-            ready_queue.push(new_process);
-            print_event(elapsed_time, "Process " + new_process.id + " (tau " + std::to_string(int(new_process.tau)) + "ms) arrived; added to ready queue", ready_queue);
+            state[new_process].remaining = front_burst(new_process);  // Set initial remaining time to the first burst length
+            push_ready(new_process);
+            if (Trace::counted) {
+                counters->ready_pushed(ready_queue.size());
+                counters->handled(EV_ARRIVAL);
+            }
+            if (Trace::windowed(elapsed_time)) {
+                log_event(elapsed_time, EV_ARRIVAL, new_process).with_tau(int(state[new_process].tau));
+            }
 
             // Check for preemption
-            if (current_process && new_process.remaining_time < current_process->remaining_time) {
-                print_event(elapsed_time, "Process " + new_process.id + " (tau " + std::to_string(int(new_process.tau)) + "ms) preempting " + current_process->id, ready_queue);
-                ready_queue.push(*current_process);
-                current_process = nullptr;
+            if (current_process != -1 && state[new_process].remaining < state[current_process].remaining) {
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(elapsed_time, EV_PREEMPT, new_process, current_process, -1).with_tau(int(state[new_process].tau));
+                }
+                push_ready(current_process);
+                if (Trace::counted) {
+                    counters->ready_pushed(ready_queue.size());
+                    counters->handled(EV_PREEMPT);
+                }
+                current_process = -1;
                 time_cpu_frees = elapsed_time + context_time / 2; // Time when CPU will be free after context switch
                 context_switch_time_remaining = context_time / 2;
 
-                if (new_process.is_cpu_bound) {
+                if (state[new_process].cpu_bound) {
                     cpu_bound_preemptions++;
                 } else {
                     io_bound_preemptions++;
@@ -74,24 +87,35 @@ void srt::simulate() {
         }
 
         // Handle I/O completion
-        if (!io_bound_map_keys.empty() && io_bound_map_keys.top() == elapsed_time) {
-            Process io_completed = io_bound_map[elapsed_time];
-            io_bound_map.erase(elapsed_time);
-            io_bound_map_keys.pop();
+        if (!io_queue.empty() && io_queue.top().first == elapsed_time) {
+            int io_completed = io_queue.top().second;
+            io_queue.pop();
 
-            io_completed.remaining_time = io_completed.tau;
-            ready_queue.push(io_completed);
-            print_event(elapsed_time, "Process " + io_completed.id + " (tau " + std::to_string(int(io_completed.tau)) + "ms) completed I/O; added to ready queue", ready_queue);
+            state[io_completed].remaining = state[io_completed].tau;
+            push_ready(io_completed);
+            if (Trace::counted) {
+                counters->ready_pushed(ready_queue.size());
+                counters->handled(EV_IO_DONE);
+            }
+            if (Trace::windowed(elapsed_time)) {
+                log_event(elapsed_time, EV_IO_DONE, io_completed).with_tau(int(state[io_completed].tau));
+            }
 
             // Check for preemption
-            if (current_process && io_completed.remaining_time < current_process->remaining_time) {
-                print_event(elapsed_time, "Process " + io_completed.id + " (tau " + std::to_string(int(io_completed.tau)) + "ms) preempting " + current_process->id, ready_queue);
-                ready_queue.push(*current_process);
-                current_process = nullptr;
+            if (current_process != -1 && state[io_completed].remaining < state[current_process].remaining) {
+                if (Trace::windowed(elapsed_time)) {
+                    log_event(elapsed_time, EV_PREEMPT, io_completed, current_process, -1).with_tau(int(state[io_completed].tau));
+                }
+                push_ready(current_process);
+                if (Trace::counted) {
+                    counters->ready_pushed(ready_queue.size());
+                    counters->handled(EV_PREEMPT);
+                }
+                current_process = -1;
                 time_cpu_frees = elapsed_time + context_time / 2;
                 context_switch_time_remaining = context_time / 2;
 
-                if (io_completed.is_cpu_bound) {
+                if (state[io_completed].cpu_bound) {
                     cpu_bound_preemptions++;
                 } else {
                     io_bound_preemptions++;
@@ -104,46 +128,58 @@ void srt::simulate() {
         if (context_switch_time_remaining > 0) {
             context_switch_time_remaining--;
             did_something = true;
-        } else if (current_process == nullptr && !ready_queue.empty() && elapsed_time >= time_cpu_frees) {
-            current_process = new Process(ready_queue.top());
-            ready_queue.pop();
+        } else if (current_process == -1 && !ready_queue.empty() && elapsed_time >= time_cpu_frees) {
+            current_process = pop_ready();
+            if (Trace::counted) {
+                counters->ready_popped();
+                counters->handled(EV_CPU_START);
+            }
 
-            time_cpu_frees = elapsed_time + current_process->remaining_time;
-            print_event(elapsed_time, "Process " + current_process->id + " (tau " + std::to_string(int(current_process->tau)) + "ms) started using the CPU for " + std::to_string(current_process->remaining_time) + "ms burst", ready_queue);
+            time_cpu_frees = elapsed_time + state[current_process].remaining;
+            if (Trace::windowed(elapsed_time)) {
+                log_event(elapsed_time, EV_CPU_START, current_process, state[current_process].remaining)
+                        .with_tau(int(state[current_process].tau));
+            }
 
-            if (current_process->is_cpu_bound) {
+            if (state[current_process].cpu_bound) {
                 cpu_bound_context_switches++;
             } else {
                 io_bound_context_switches++;
             }
-            total_cpu_time += current_process->remaining_time;  // Track total CPU time
+            total_cpu_time += state[current_process].remaining;  // Track total CPU time
             did_something = true;
         }
 
         // Handle CPU burst completion
-        if (current_process && elapsed_time == time_cpu_frees) {
-            current_process->bursts.front() -= current_process->remaining_time;
-            if (current_process->bursts.front() <= 0) {
-                current_process->bursts.erase(current_process->bursts.begin());
-
-                if (current_process->bursts.empty()) {
-                    print_event(elapsed_time, "Process " + current_process->id + " terminated", ready_queue);
-                    delete current_process;
-                    current_process = nullptr;
+        if (current_process != -1 && elapsed_time == time_cpu_frees) {
+            if (front_burst(current_process) - state[current_process].remaining <= 0) {
+                state[current_process].cursor++;
+
+                if (bursts_left(current_process) == 0) {
+                    if (Trace::counted) {
+                        counters->handled(EV_TERMINATED);
+                    }
+                    if (Trace::enabled) {
+                        log_event(elapsed_time, EV_TERMINATED, current_process);
+                    }
+                    current_process = -1;
                 } else {
-                    double new_tau = calculate_new_tau(current_process->tau, current_process->bursts.front(), alpha, lambda);
-                    print_event(elapsed_time, "Recalculated tau for process " + current_process->id + ": old tau " + std::to_string(int(current_process->tau)) + "ms ==> new tau " + std::to_string(int(new_tau)) + "ms", ready_queue);
-                    current_process->tau = new_tau;
-                    current_process->remaining_time = new_tau;
-                    io_bound_map[elapsed_time + new_tau + context_time / 2] = *current_process;
-                    io_bound_map_keys.push(elapsed_time + new_tau + context_time / 2);
-                    delete current_process;
-                    current_process = nullptr;
+                    double new_tau = calculate_new_tau(state[current_process].tau, front_burst(current_process), alpha, lambda);
+                    if (Trace::windowed(elapsed_time)) {
+                        log_event(elapsed_time, EV_TAU_RECALC, current_process, int(state[current_process].tau), int(new_tau));
+                    }
+                    state[current_process].tau = new_tau;
+                    state[current_process].remaining = new_tau;
+                    io_queue.push(std::make_pair((sim_time) (elapsed_time + new_tau + context_time / 2), current_process));
+                    if (Trace::counted) {
+                        counters->handled(EV_TAU_RECALC);
+                        counters->io_pushed(io_queue.size());
+                    }
+                    current_process = -1;
                 }
             } else {
-                current_process->remaining_time = 0; // Finished burst
-                delete current_process;
-                current_process = nullptr;
+                state[current_process].remaining = 0; // Finished burst
+                current_process = -1;
             }
             did_something = true;
         }
@@ -154,7 +190,9 @@ void srt::simulate() {
         }
     }
 
-    print_event(elapsed_time, "Simulator ended for SRT", ready_queue);
+    if (Trace::enabled) {
+        log_event(elapsed_time, EV_SIM_END);
+    }
 
     // Update statistics after simulation
     if (elapsed_time > 0) {
@@ -172,26 +210,64 @@ void srt::simulate() {
     num_io_switches = io_bound_context_switches;
     cpu_preempt = cpu_bound_preemptions;
     io_preempt = io_bound_preemptions;
+    if (Trace::counted) {
+        counters->handled(EV_SIM_END);
+        counters->preemptions = cpu_preempt + io_preempt;
+        counters->take_memory(arena);
+    }
+}
+
+// runs the event loop instantiated for the requested trace level, keeping only what filter accepts,
+// and the counted one of it when there are counters to fill in
+void srt::simulate(TraceLevel level, const TraceFilter* filter, PerfCounters* counters, RunBudget* budget) {
+    log.set_filter(filter);
+    this->counters = counters;
+    this->budget = budget;
+    switch (level) {
+        case TRACE_OFF:
+            counters != nullptr ? run<Counted<TraceOff> >() : run<TraceOff>();
+            break;
+        case TRACE_CUTOFF:
+            counters != nullptr ? run<Counted<TraceCutoff> >() : run<TraceCutoff>();
+            break;
+        case TRACE_FULL:
+            counters != nullptr ? run<Counted<TraceFull> >() : run<TraceFull>();
+            break;
+    }
 }
 
 // Implementing the write_statistics function for SRT
-void srt::write_statistics(const std::string& filename) const {
-    std::fstream outfile(filename, std::ios::app);
+SimStats srt::statistics() const {
+    // a class that never ran reports zeros rather than 0 / 0
+    const bool cpu_ran = cpu_bound_context_switches > 0, io_ran = io_bound_context_switches > 0;
+    SimStats stats;
+    stats.cpu_util = cpu_util;
+    stats.cpu_wait = cpu_ran ? cpu_wait : 0;
+    stats.io_wait = io_ran ? io_wait : 0;
+    stats.tot_wait = cpu_ran && io_ran ? (cpu_wait + io_wait) / 2 : 0;
+    stats.cpu_turn = cpu_ran ? cpu_turn : 0;
+    stats.io_turn = io_ran ? io_turn : 0;
+    stats.tot_turn = cpu_ran && io_ran ? (cpu_turn + io_turn) / 2 : 0;
+    stats.num_cpu_switches = num_cpu_switches;
+    stats.num_io_switches = num_io_switches;
+    stats.cpu_preempt = cpu_preempt;
+    stats.io_preempt = io_preempt;
+    return stats;
+}
 
+void srt::write_statistics(const SimStats& stats, std::ostream& outfile) {
     outfile << "Algorithm SRT" << std::endl;
-    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (cpu_util * 100) << "%" << std::endl;
-    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << (cpu_bound_context_switches > 0 ? cpu_wait : 0) << " ms" << std::endl;
-    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << (io_bound_context_switches > 0 ? io_wait : 0) << " ms" << std::endl;
-    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << ((cpu_bound_context_switches > 0 && io_bound_context_switches > 0) ? ((cpu_wait + io_wait) / 2) : 0) << " ms" << std::endl;
-    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << (cpu_bound_context_switches > 0 ? cpu_turn : 0) << " ms" << std::endl;
-    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << (io_bound_context_switches > 0 ? io_turn : 0) << " ms" << std::endl;
-    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << ((cpu_bound_context_switches > 0 && io_bound_context_switches > 0) ? ((cpu_turn + io_turn) / 2) : 0) << " ms" << std::endl;
-    outfile << "-- CPU-bound number of context switches: " << num_cpu_switches << std::endl;
-    outfile << "-- I/O-bound number of context switches: " << num_io_switches << std::endl;
-    outfile << "-- overall number of context switches: " << num_cpu_switches + num_io_switches << std::endl;
-    outfile << "-- CPU-bound number of preemptions: " << cpu_preempt << std::endl;
-    outfile << "-- I/O-bound number of preemptions: " << io_preempt << std::endl;
-    outfile << "-- overall number of preemptions: " << cpu_preempt + io_preempt << std::endl << std::endl;
-
-    outfile.close();
+    outfile << "-- CPU utilization: " << std::fixed << std::setprecision(3) << (stats.cpu_util * 100) << "%" << std::endl;
+    outfile << "-- CPU-bound average wait time: " << std::fixed << std::setprecision(3) << stats.cpu_wait << " ms" << std::endl;
+    outfile << "-- I/O-bound average wait time: " << std::fixed << std::setprecision(3) << stats.io_wait << " ms" << std::endl;
+    outfile << "-- overall average wait time: " << std::fixed << std::setprecision(3) << stats.tot_wait << " ms" << std::endl;
+    outfile << "-- CPU-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.cpu_turn << " ms" << std::endl;
+    outfile << "-- I/O-bound average turnaround time: " << std::fixed << std::setprecision(3) << stats.io_turn << " ms" << std::endl;
+    outfile << "-- overall average turnaround time: " << std::fixed << std::setprecision(3) << stats.tot_turn << " ms" << std::endl;
+    outfile << "-- CPU-bound number of context switches: " << stats.num_cpu_switches << std::endl;
+    outfile << "-- I/O-bound number of context switches: " << stats.num_io_switches << std::endl;
+    outfile << "-- overall number of context switches: " << stats.num_cpu_switches + stats.num_io_switches << std::endl;
+    outfile << "-- CPU-bound number of preemptions: " << stats.cpu_preempt << std::endl;
+    outfile << "-- I/O-bound number of preemptions: " << stats.io_preempt << std::endl;
+    outfile << "-- overall number of preemptions: " << stats.cpu_preempt + stats.io_preempt << std::endl << std::endl;
 }
@@ -4,42 +4,75 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include "process.h"
+#include "workload.h"
+#include "arena.h"
+#include "event_log.h"
+#include "trace_policy.h"
+#include "sim_stats.h"
 #include <queue>
 #include <algorithm>
 #include <map>
 #include <cmath>
 
+struct PerfCounters;
+class RunBudget;
+
 class srt {
 public:
-    srt(const std::vector<Process>& processes, int context_time, double alpha, double lambda)
-            : processes(processes), context_time(context_time), elapsed_time(0), alpha(alpha), lambda(lambda),
+    srt(const Workload& workload, int context_time, double alpha, double lambda)
+            : workload(workload), state(workload.initial_state(std::ceil(1 / lambda))),
+              ready_queue(ArenaAllocator<int>(&arena)), queue_snapshot(ArenaAllocator<int>(&arena)), log("SRT"),
+              counters(nullptr), budget(nullptr), context_time(context_time), elapsed_time(0), alpha(alpha), lambda(lambda),
               cpu_util(0), cpu_wait(0), io_wait(0), cpu_turn(0), io_turn(0),
               num_cpu_switches(0), num_io_switches(0), cpu_preempt(0), io_preempt(0),
               cpu_bound_context_switches(0), io_bound_context_switches(0),
-              cpu_bound_preemptions(0), io_bound_preemptions(0) {
-        for (size_t i = 0; i < this->processes.size(); ++i) {
-            this->processes[i].tau = std::ceil(1 / lambda);  // Initial tau value based on lambda
-        }
+              cpu_bound_preemptions(0), io_bound_preemptions(0),
+              io_queue(make_arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > >(arena)) {
     }
 
-    void simulate();
+    // with counters given, the run also fills them in (see perf_counters.h); with a budget it stops
+    // once that is spent (see run_budget.h)
+    void simulate(TraceLevel level = TRACE_CUTOFF, const TraceFilter* filter = nullptr,
+                  PerfCounters* counters = nullptr, RunBudget* budget = nullptr);
+
+    SimStats statistics() const;
+    // writes the SRT block for stats to out
+    static void write_statistics(const SimStats& stats, std::ostream& out);
 
-    void write_statistics(const std::string& filename) const;
+    // the arena the engine containers allocate from, to check the event loop stays allocation-free
+    const Arena& memory() const { return arena; }
+
+    // everything the simulation traced, render() it to get the text
+    const EventLog& events() const { return log; }
+    // the same log, for handing it a drain (see EventLog::set_drain()) before simulate()
+    EventLog& events() { return log; }
 
 private:
+    // the event loop, instantiated once per trace policy (see trace_policy.h)
+    template <class Trace>
+    void run();
+
     struct CompareRemainingTime {
-        bool operator()(const Process &a, const Process &b) const {
-            if (a.remaining_time == b.remaining_time) {
-                return a.id > b.id;  // Tie-breaking by process ID
+        const srt* s;
+        explicit CompareRemainingTime(const srt* s) : s(s) {}
+        bool operator()(int a, int b) const {
+            if (s->state[a].remaining == s->state[b].remaining) {
+                return s->state[a].id_rank > s->state[b].id_rank;  // Tie-breaking by process ID
             }
-            return a.remaining_time > b.remaining_time;
+            return s->state[a].remaining > s->state[b].remaining;
         }
     };
 
-    std::vector<Process> processes;
-    std::priority_queue<Process, std::vector<Process>, CompareRemainingTime> ready_queue;
-    int context_time, elapsed_time;
+    const Workload& workload;
+    std::vector<ProcState> state;  // hot per-process state (cursor, remaining time, tau), indexed by handle
+    Arena arena; // everything the simulation allocates, freed when the scheduler goes away
+    arena_vector<int> ready_queue;     // binary heap ordered by CompareRemainingTime
+    arena_vector<int> queue_snapshot;  // scratch space for logging the ready queue in order
+    EventLog log;                      // trace of the run, rendered on demand
+    PerfCounters* counters;            // what a counted run fills in, nullptr otherwise
+    RunBudget* budget;                 // stops the run when spent, nullptr for no limit
+    int context_time;
+    sim_time elapsed_time;
     double alpha, lambda;
 
     // Statistics variables
@@ -58,14 +91,27 @@ private:
     int io_bound_context_switches;
     int cpu_bound_preemptions;
     int io_bound_preemptions;
-    static bool compare_by_arrival_time(const Process& a, const Process& b);
 
-    std::map<int, Process> io_bound_map;
-    std::priority_queue<int, std::vector<int>, std::greater<int> > io_bound_map_keys;
+    // (completion time, process) of everyone blocked on I/O, a map keyed on time alone lost
+    // one of two processes finishing I/O at the same millisecond
+    arena_priority_queue<std::pair<sim_time, int>, std::greater<std::pair<sim_time, int> > > io_queue;
 
-    void print_event(int time, const std::string &event, const std::priority_queue<Process, std::vector<Process>, CompareRemainingTime> &ready_queue);
+    void push_ready(int p) {
+        ready_queue.push_back(p);
+        std::push_heap(ready_queue.begin(), ready_queue.end(), CompareRemainingTime(this));
+    }
+    int pop_ready() {
+        std::pop_heap(ready_queue.begin(), ready_queue.end(), CompareRemainingTime(this));
+        int p = ready_queue.back();
+        ready_queue.pop_back();
+        return p;
+    }
+
+    EventRecord& log_event(sim_time time, EventKind kind, int p = -1, int a = 0, int b = 0);
     double calculate_new_tau(double old_tau, int actual_burst, double alpha, double lambda);
-    bool processHasId(const Process &p, const std::string &id);
+
+    int bursts_left(int p) const { return workload.num_bursts(p) - state[p].cursor; }
+    int front_burst(int p) const { return bursts_left(p) > 0 ? workload.burst(p, state[p].cursor) : 0; }
 };
 
 #endif //OPSYSPROJ_SRT_H
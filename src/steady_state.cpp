@@ -0,0 +1,78 @@
+#include "steady_state.h"
+#include <cmath>
+#include <iomanip>
+
+const int SteadyState::MAX_GROUPS;
+const int SteadyState::BATCHES;
+
+void SteadyState::merge() {
+    // pairs of groups become one, so the group means stay means of group observations
+    const size_t half = groups.size() / 2;
+    for (size_t g = 0; g < half; ++g) {
+        groups[g] = (groups[2 * g] + groups[2 * g + 1]) / 2;
+    }
+    groups.resize(half);
+    group *= 2;
+}
+
+int SteadyState::warm_up_groups() const {
+    const int k = (int) groups.size();
+    if (k < 2) {
+        return 0;
+    }
+    // MSER(d) = sum over i >= d of (z_i - mean)^2 / (k - d)^2, from suffix sums walking backwards
+    double sum = 0, squares = 0;
+    double best = INFINITY;
+    int best_d = 0;
+    for (int d = k - 1; d >= 0; --d) {
+        sum += groups[d];
+        squares += groups[d] * groups[d];
+        if (d > k / 2) {
+            continue;
+        }
+        const double m = k - d;
+        const double mser = (squares - sum * sum / m) / (m * m);
+        // <= keeps the earliest cut among ties, dropping as little as possible
+        if (mser <= best) {
+            best = mser;
+            best_d = d;
+        }
+    }
+    return best_d;
+}
+
+Interval SteadyState::interval() const {
+    const int d = warm_up_groups();
+    const int left = (int) groups.size() - d;
+    const int batches = left < BATCHES ? left : BATCHES;
+    std::vector<double> means(batches);
+    if (batches == 0) {
+        return confidence_interval(means);
+    }
+    // equal batches; the few groups that do not fit are dropped from the front, next to the warm-up
+    const int size = left / batches;
+    const int first = (int) groups.size() - batches * size;
+    for (int b = 0; b < batches; ++b) {
+        double sum = 0;
+        for (int g = first + b * size; g < first + (b + 1) * size; ++g) {
+            sum += groups[g];
+        }
+        means[b] = sum / size;
+    }
+    return confidence_interval(means);
+}
+
+// one line of the steady-state block
+static void write_estimate(std::ostream& out, const char* name, const SteadyState& series) {
+    Interval i = series.interval();
+    out << "-- " << name << ": " << std::fixed << std::setprecision(3) << i.mean << " +/- " << i.half_width
+        << " ms (first " << series.truncation() << " of " << series.size() << " CPU bursts dropped, "
+        << i.samples << " batch means)" << std::endl;
+}
+
+void write_steady_state(const SteadyStateProbe& probe, const std::string& algorithm, std::ostream& out) {
+    out << "Steady state " << algorithm << std::endl;
+    write_estimate(out, "overall average wait time", probe.wait);
+    write_estimate(out, "overall average turnaround time", probe.turnaround);
+    out << std::endl;
+}
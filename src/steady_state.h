@@ -0,0 +1,67 @@
+#ifndef OPSYSPROJ_STEADY_STATE_H
+#define OPSYSPROJ_STEADY_STATE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "replication.h"
+
+/*
+ * Steady-state estimate of one per-burst series, gathered during a single long run.
+ *
+ * The start of a run is a transient: the ready queue fills up from empty, so the first bursts
+ * wait less than they will later on and pull the plain average down. add() averages the series
+ * in groups of five as it comes in; interval() then drops the warm-up the MSER-5 rule picks
+ * (the prefix whose removal leaves the smallest standard error of the mean, looked for in the
+ * first half of the groups) and builds a batch-means confidence interval from what is left,
+ * so one run of n processes gives what would otherwise take many independent short runs.
+ *
+ * Memory stays bounded: once MAX_GROUPS groups are held, neighbours are merged and the group
+ * size doubles, which turns MSER-5 into MSER-10, MSER-20, ... on very long runs.
+ */
+class SteadyState {
+public:
+    SteadyState() : group(5), filled(0), partial(0), count(0) {}
+
+    void add(double value) {
+        partial += value;
+        count++;
+        if (++filled == group) {
+            groups.push_back(partial / group);
+            partial = 0;
+            filled = 0;
+            if ((int) groups.size() == MAX_GROUPS) {
+                merge();
+            }
+        }
+    }
+
+    // observations added so far
+    long long size() const { return count; }
+    // observations dropped from the front as warm-up
+    long long truncation() const { return (long long) warm_up_groups() * group; }
+    // mean of the series past the warm-up, with its 95% interval from BATCHES batch means
+    Interval interval() const;
+
+    static const int MAX_GROUPS = 1 << 16;
+    static const int BATCHES = 20;
+
+private:
+    std::vector<double> groups; // group means, in the order the series came in
+    int group, filled;          // observations per group, and in the group being filled
+    double partial;             // sum of the group being filled
+    long long count;
+
+    void merge();
+    int warm_up_groups() const;
+};
+
+// the series an engine feeds during a run, one value per CPU burst in dispatch order
+struct SteadyStateProbe {
+    SteadyState wait, turnaround;
+};
+
+// writes the steady-state estimates for algorithm, the block that goes after its usual one
+void write_steady_state(const SteadyStateProbe& probe, const std::string& algorithm, std::ostream& out);
+
+#endif //OPSYSPROJ_STEADY_STATE_H
@@ -0,0 +1,402 @@
+#include "timeline.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+static const char* const TIMELINE_KIND_NAMES[NUM_TIMELINE_KINDS] = {
+        "running", "switch-in", "switch-out", "ready", "io"
+};
+
+const char* timeline_kind_name(TimelineKind kind) {
+    return TIMELINE_KIND_NAMES[kind];
+}
+
+// hands [start, end) to out unless it is empty
+static void emit(IntervalSink& out, sim_time start, sim_time end, int pid, TimelineKind kind) {
+    if (end > start) {
+        TimelineInterval i = {start, end, pid, kind};
+        out.interval(i);
+    }
+}
+
+IntervalBuilder::IntervalBuilder(int num_processes, int t_cs)
+        : half_switch(t_cs / 2), ready_since(num_processes, -1), running(-1), started(0), switched_out(-1),
+          switch_out(0) {}
+
+sim_time IntervalBuilder::end_switch_out(sim_time t, IntervalSink& out) {
+    sim_time end = std::min(switch_out + half_switch, t);
+    emit(out, switch_out, end, switched_out, TL_SWITCH_OUT);
+    switched_out = -1;
+    return end;
+}
+
+void IntervalBuilder::add(const EventRecord& r, IntervalSink& out) {
+    const sim_time t = r.time();
+
+    // the running process's slice ends at t, followed by its switch out
+    int stopped = -1;
+    switch (r.kind) {
+        case EV_BURST_DONE:
+        case EV_TERMINATED:
+        case EV_TAU_RECALC:
+            stopped = r.pid == running ? running : -1;
+            break;
+        case EV_SLICE_PREEMPT:
+        case EV_SLICE_EXPIRED:
+            stopped = running;
+            break;
+        case EV_PREEMPT:
+            stopped = r.a == running ? running : -1;
+            break;
+        case EV_SIM_END:
+            if (running != -1) {
+                emit(out, started, t, running, TL_RUNNING);
+                running = -1;
+            }
+            if (switched_out != -1) {
+                end_switch_out(t, out);
+            }
+            break;
+        default:
+            break;
+    }
+    if (stopped != -1) {
+        emit(out, started, t, stopped, TL_RUNNING);
+        if (switched_out != -1) {
+            end_switch_out(t, out);
+        }
+        switched_out = stopped;
+        switch_out = t;
+        running = -1;
+        if (r.kind != EV_BURST_DONE && r.kind != EV_TERMINATED && r.kind != EV_TAU_RECALC) {
+            ready_since[stopped] = t + half_switch;  // back in a queue once it has switched out
+        }
+    }
+
+    switch (r.kind) {
+        case EV_ARRIVAL:
+        case EV_IO_DONE:
+        case EV_PREEMPT:
+            ready_since[r.pid] = t;
+            break;
+        case EV_CPU_START:
+        case EV_CPU_RESUME: {
+            sim_time switch_in = t - half_switch;
+            if (running != -1) {
+                // a burst that stopped without an event of its own, it gives way to the switch in
+                switch_in = std::max(switch_in, started);
+                emit(out, started, switch_in, running, TL_RUNNING);
+            }
+            if (switched_out != -1) {
+                switch_in = std::max(switch_in, end_switch_out(t, out));
+            }
+            if (ready_since[r.pid] >= 0) {
+                emit(out, ready_since[r.pid], switch_in, r.pid, TL_READY);
+                ready_since[r.pid] = -1;
+            }
+            emit(out, switch_in, t, r.pid, TL_SWITCH_IN);
+            running = r.pid;
+            started = t;
+            break;
+        }
+        case EV_IO_BLOCK:
+            emit(out, t, t + r.a, r.pid, TL_IO);
+            break;
+        default:
+            break;
+    }
+}
+
+Timeline Timeline::from_log(const EventLog& log, int num_processes, int t_cs) {
+    Timeline timeline(log.name());
+    IntervalBuilder builder(num_processes, t_cs);
+    for (size_t e = 0; e < log.size(); ++e) {
+        builder.add(log[e], timeline);
+    }
+    timeline.build_index(num_processes);
+    return timeline;
+}
+
+void Timeline::interval(const TimelineInterval& i) {
+    if (i.kind == TL_READY || i.kind == TL_IO) {
+        waits.push_back(i);
+        return;
+    }
+    if (!cpu.empty() && cpu.back().pid == i.pid && cpu.back().kind == i.kind && cpu.back().end == i.start) {
+        cpu.back().end = i.end;
+    } else {
+        cpu.push_back(i);
+    }
+}
+
+// orders intervals by start time
+struct CompareStart {
+    bool operator()(const TimelineInterval& a, const TimelineInterval& b) const { return a.start < b.start; }
+};
+
+// orders Timeline::by_process entries by the start of the interval they refer to
+struct CompareIndexedStart {
+    const std::vector<TimelineInterval>* cpu;
+    const std::vector<TimelineInterval>* waits;
+
+    sim_time start(int k) const {
+        return k < (int) cpu->size() ? (*cpu)[k].start : (*waits)[k - cpu->size()].start;
+    }
+    bool operator()(int a, int b) const { return start(a) < start(b); }
+};
+
+void Timeline::build_index(int num_processes) {
+    std::stable_sort(cpu.begin(), cpu.end(), CompareStart());
+    std::stable_sort(waits.begin(), waits.end(), CompareStart());
+    max_end.assign(waits.size(), 0);
+    index_waits(0, (int) waits.size());
+
+    // counting sort by process, then each process's share by start time
+    process_offset.assign(num_processes + 1, 0);
+    for (size_t k = 0; k < cpu.size(); ++k) {
+        process_offset[cpu[k].pid + 1]++;
+    }
+    for (size_t k = 0; k < waits.size(); ++k) {
+        process_offset[waits[k].pid + 1]++;
+    }
+    for (int h = 0; h < num_processes; ++h) {
+        process_offset[h + 1] += process_offset[h];
+    }
+    by_process.resize(size());
+    std::vector<int> fill(process_offset.begin(), process_offset.end() - 1);
+    for (size_t k = 0; k < cpu.size(); ++k) {
+        by_process[fill[cpu[k].pid]++] = (int) k;
+    }
+    for (size_t k = 0; k < waits.size(); ++k) {
+        by_process[fill[waits[k].pid]++] = (int) (cpu.size() + k);
+    }
+    CompareIndexedStart by_start = {&cpu, &waits};
+    for (int h = 0; h < num_processes; ++h) {
+        std::stable_sort(by_process.begin() + process_offset[h], by_process.begin() + process_offset[h + 1], by_start);
+    }
+}
+
+// waits[(lo + hi) / 2] is the root of the subtree over [lo, hi); returns the latest end in it
+sim_time Timeline::index_waits(int lo, int hi) {
+    if (lo >= hi) {
+        return std::numeric_limits<sim_time>::min();
+    }
+    int mid = lo + (hi - lo) / 2;
+    sim_time latest = std::max(waits[mid].end, std::max(index_waits(lo, mid), index_waits(mid + 1, hi)));
+    max_end[mid] = latest;
+    return latest;
+}
+
+// adds the waits in [lo, hi) covering t to found; a subtree ending by t, or the right one of a
+// node starting after t, cannot hold any
+void Timeline::stab(int lo, int hi, sim_time t, std::vector<int>& found) const {
+    if (lo >= hi) {
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    if (max_end[mid] <= t) {
+        return;
+    }
+    stab(lo, mid, t, found);
+    if (waits[mid].start <= t) {
+        if (t < waits[mid].end) {
+            found.push_back(mid);
+        }
+        stab(mid + 1, hi, t, found);
+    }
+}
+
+const TimelineInterval* Timeline::cpu_at(sim_time t) const {
+    TimelineInterval probe = {t, t, -1, 0};
+    std::vector<TimelineInterval>::const_iterator it = std::upper_bound(cpu.begin(), cpu.end(), probe, CompareStart());
+    if (it == cpu.begin() || (it - 1)->end <= t) {
+        return nullptr;
+    }
+    return &*(it - 1);
+}
+
+std::vector<int> Timeline::queued_at(sim_time t) const {
+    std::vector<int> found;
+    stab(0, (int) waits.size(), t, found);
+    // waits are kept by start time, so index order is the order they joined a queue in
+    std::sort(found.begin(), found.end());
+    std::vector<int> queued;
+    for (size_t k = 0; k < found.size(); ++k) {
+        if (waits[found[k]].kind == TL_READY) {
+            queued.push_back(waits[found[k]].pid);
+        }
+    }
+    return queued;
+}
+
+std::vector<TimelineInterval> Timeline::intervals_of(int pid) const {
+    std::vector<TimelineInterval> intervals;
+    if (pid < 0 || pid + 1 >= (int) process_offset.size()) {
+        return intervals;
+    }
+    for (int k = process_offset[pid]; k < process_offset[pid + 1]; ++k) {
+        const int i = by_process[k];
+        intervals.push_back(i < (int) cpu.size() ? cpu[i] : waits[i - cpu.size()]);
+    }
+    return intervals;
+}
+
+namespace {
+
+void write_u32(std::ostream& out, uint32_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void write_string(std::ostream& out, const std::string& s) {
+    write_u32(out, (uint32_t) s.size());
+    out.write(s.data(), (std::streamsize) s.size());
+}
+
+bool read_u32(std::istream& in, uint32_t& value) {
+    return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+bool read_string(std::istream& in, std::string& s) {
+    uint32_t length;
+    if (!read_u32(in, length)) {
+        return false;
+    }
+    s.resize(length);
+    return length == 0 || (bool) in.read(&s[0], length);
+}
+
+bool read_intervals(std::istream& in, std::vector<TimelineInterval>& intervals, uint32_t count) {
+    intervals.resize(count);
+    return count == 0 || (bool) in.read(reinterpret_cast<char*>(intervals.data()), count * sizeof(TimelineInterval));
+}
+
+}
+
+void Timeline::write(std::ostream& out) const {
+    write_string(out, algorithm);
+    write_u32(out, (uint32_t) cpu.size());
+    write_u32(out, (uint32_t) waits.size());
+    out.write(reinterpret_cast<const char*>(cpu.data()), (std::streamsize) (cpu.size() * sizeof(TimelineInterval)));
+    out.write(reinterpret_cast<const char*>(waits.data()), (std::streamsize) (waits.size() * sizeof(TimelineInterval)));
+}
+
+bool Timeline::read(std::istream& in, int num_processes) {
+    uint32_t cpu_count, wait_count;
+    if (!read_string(in, algorithm) || !read_u32(in, cpu_count) || !read_u32(in, wait_count) ||
+        !read_intervals(in, cpu, cpu_count) || !read_intervals(in, waits, wait_count)) {
+        return false;
+    }
+    for (size_t k = 0; k < size(); ++k) {
+        const TimelineInterval& i = k < cpu.size() ? cpu[k] : waits[k - cpu.size()];
+        if (i.pid < 0 || i.pid >= num_processes) {
+            return false;
+        }
+    }
+    build_index(num_processes);
+    return true;
+}
+
+TimelineSink::TimelineSink(const std::string& stats_filename, int t_cs)
+        : stats_file(stats_filename.c_str(), std::ios::out | std::ios::trunc), t_cs(t_cs) {
+    stats = &stats_file;
+}
+
+void TimelineSink::events(const Workload& workload, const EventLog& log) {
+    if (ids.empty()) {
+        for (int h = 0; h < workload.size(); ++h) {
+            ids.push_back(workload.id(h));
+        }
+    }
+    runs.push_back(Timeline::from_log(log, workload.size(), t_cs));
+}
+
+void TimelineSink::write(const std::string& filename) const {
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    file.write("OSPTL001", 8);
+    write_u32(file, (uint32_t) sizeof(TimelineInterval));
+    write_u32(file, (uint32_t) ids.size());
+    for (size_t h = 0; h < ids.size(); ++h) {
+        write_string(file, ids[h]);
+    }
+    write_u32(file, (uint32_t) runs.size());
+    for (size_t r = 0; r < runs.size(); ++r) {
+        runs[r].write(file);
+    }
+    if (!file) {
+        throw std::runtime_error("cannot write " + filename);
+    }
+}
+
+void query_timelines(const std::string& filename, const std::string& query, std::ostream& out) {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot read " + filename);
+    }
+    char magic[8];
+    uint32_t interval_size, num_ids, num_runs;
+    if (!file.read(magic, 8) || std::memcmp(magic, "OSPTL001", 8) != 0 || !read_u32(file, interval_size)) {
+        throw std::runtime_error(filename + " is not a timeline file");
+    }
+    if (interval_size != sizeof(TimelineInterval)) {
+        throw std::runtime_error(filename + " was written with another width of simulated time");
+    }
+    std::vector<std::string> ids;
+    if (!read_u32(file, num_ids)) {
+        throw std::runtime_error(filename + " is truncated");
+    }
+    ids.resize(num_ids);
+    for (uint32_t h = 0; h < num_ids; ++h) {
+        if (!read_string(file, ids[h])) {
+            throw std::runtime_error(filename + " is truncated");
+        }
+    }
+    if (!read_u32(file, num_runs)) {
+        throw std::runtime_error(filename + " is truncated");
+    }
+
+    // a number is a time, anything else a process ID
+    const bool by_time = !query.empty() && query.find_first_not_of("0123456789") == std::string::npos;
+    int pid = -1;
+    if (!by_time) {
+        pid = (int) (std::find(ids.begin(), ids.end(), query) - ids.begin());
+        if (pid == (int) ids.size()) {
+            throw std::runtime_error("no process " + query + " in " + filename);
+        }
+    }
+
+    for (uint32_t r = 0; r < num_runs; ++r) {
+        Timeline timeline;
+        if (!timeline.read(file, (int) num_ids)) {
+            throw std::runtime_error(filename + " is truncated");
+        }
+        if (by_time) {
+            const sim_time t = std::stoll(query);
+            out << timeline.name() << " at time " << t << "ms: ";
+            const TimelineInterval* on_cpu = timeline.cpu_at(t);
+            if (on_cpu == nullptr) {
+                out << "CPU idle";
+            } else {
+                out << "process " << ids[on_cpu->pid] << ' ' << timeline_kind_name((TimelineKind) on_cpu->kind);
+            }
+            // not the trace's [Q ...]: the timeline knows when processes joined, not the algorithm's order
+            std::vector<int> queued = timeline.queued_at(t);
+            out << "; waiting, by time joined:";
+            if (queued.empty()) {
+                out << " none";
+            }
+            for (size_t k = 0; k < queued.size(); ++k) {
+                out << ' ' << ids[queued[k]];
+            }
+            out << std::endl;
+        } else {
+            out << timeline.name() << ": process " << query << std::endl;
+            std::vector<TimelineInterval> intervals = timeline.intervals_of(pid);
+            for (size_t k = 0; k < intervals.size(); ++k) {
+                out << "-- " << intervals[k].start << "ms to " << intervals[k].end << "ms: "
+                    << timeline_kind_name((TimelineKind) intervals[k].kind) << std::endl;
+            }
+        }
+    }
+}
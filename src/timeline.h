@@ -0,0 +1,145 @@
+#ifndef OPSYSPROJ_TIMELINE_H
+#define OPSYSPROJ_TIMELINE_H
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "event_log.h"
+#include "output_sink.h"
+#include "sim_time.h"
+
+// what a process is doing over a TimelineInterval
+enum TimelineKind {
+    TL_RUNNING,     // on the CPU
+    TL_SWITCH_IN,   // being switched onto the CPU
+    TL_SWITCH_OUT,  // being switched off it
+    TL_READY,       // waiting in a ready queue
+    TL_IO,          // blocked on I/O
+    NUM_TIMELINE_KINDS
+};
+
+const char* timeline_kind_name(TimelineKind kind);
+
+// process pid spent [start, end) ms doing kind
+struct TimelineInterval {
+    sim_time start, end;
+    int pid;
+    int kind;
+};
+
+// receives intervals from an IntervalBuilder as they end
+class IntervalSink {
+public:
+    virtual ~IntervalSink() {}
+    virtual void interval(const TimelineInterval& i) = 0;
+};
+
+/*
+ * Turns a run's events back into who was doing what when. The records say when a burst starts
+ * and stops and when a process joins a queue or blocks; the CPU slice, the switches either
+ * side of it (t_cs / 2 each, cut short where the algorithm starts the next burst sooner) and
+ * the waits in between are closed off as the events that end them come in. Only a few words
+ * per process are kept, so a log of any length is turned into intervals in one pass.
+ */
+class IntervalBuilder {
+public:
+    IntervalBuilder(int num_processes, int t_cs);
+
+    // the next event of the log; every interval it ends goes to out
+    void add(const EventRecord& r, IntervalSink& out);
+
+private:
+    int half_switch;
+    std::vector<sim_time> ready_since;  // when each process last joined a ready queue, -1 when it is not in one
+    int running;          // process whose CPU slice is open, -1 for none
+    sim_time started;     // when that slice started
+    int switched_out;     // process whose switch out is not closed yet, -1 for none
+    sim_time switch_out;  // when it started
+
+    // closes the open switch out, at t at the latest, and returns when it ended
+    sim_time end_switch_out(sim_time t, IntervalSink& out);
+};
+
+/*
+ * A run's CPU timeline as intervals, with an index for time queries.
+ *
+ * Every stretch of time a process spends in one state is a single 24 byte row however many
+ * milliseconds it lasts, and a process running on past an expired slice stays one row, so the
+ * timeline grows with the number of scheduling decisions, never with the length of the run.
+ * CPU intervals (running, switching) never overlap and are kept by start time, so who holds the
+ * CPU at t is a binary search. Waits overlap each other; they are kept by start time as an
+ * implicit binary search tree, each node knowing the latest end below it, so the waits covering
+ * t are found in O(log n + k). Each process's intervals are reachable through a per-process index.
+ */
+class Timeline : public IntervalSink {
+public:
+    explicit Timeline(const std::string& algorithm = "") : algorithm(algorithm) {}
+
+    // the intervals of one run's log, indexed
+    static Timeline from_log(const EventLog& log, int num_processes, int t_cs);
+
+    // appends an interval, merging it into the previous CPU interval when it carries straight on
+    void interval(const TimelineInterval& i);
+    // builds the indexes, after the last interval and before any query
+    void build_index(int num_processes);
+
+    const std::string& name() const { return algorithm; }
+    size_t size() const { return cpu.size() + waits.size(); }
+
+    // the CPU interval covering t, nullptr when the CPU is idle then
+    const TimelineInterval* cpu_at(sim_time t) const;
+    // processes in a ready queue at t, by when they joined it; only FCFS and RR dispatch in that order
+    std::vector<int> queued_at(sim_time t) const;
+    // every interval of process pid, CPU and waits, by start time
+    std::vector<TimelineInterval> intervals_of(int pid) const;
+
+    void write(std::ostream& out) const;
+    // reads what write() wrote and indexes it; returns false if the stream ends early
+    bool read(std::istream& in, int num_processes);
+
+private:
+    std::string algorithm;
+    std::vector<TimelineInterval> cpu;    // running and switches, by start time
+    std::vector<TimelineInterval> waits;  // ready and I/O, by start time
+    std::vector<sim_time> max_end;        // latest end in the subtree of each node of waits
+    std::vector<int> process_offset;      // process h's intervals are by_process[process_offset[h], process_offset[h + 1])
+    std::vector<int> by_process;          // cpu index i as i, waits index i as cpu.size() + i
+
+    sim_time index_waits(int lo, int hi);
+    void stab(int lo, int hi, sim_time t, std::vector<int>& found) const;
+};
+
+/*
+ * Keeps a Timeline of every run it is handed and writes the statistics as text, like FileSink.
+ * write() saves the timelines with the workload's process IDs, for "MAIN timeline" to query.
+ *
+ * The file is binary, in host byte order: "OSPTL001", 4 byte sizeof(TimelineInterval), 4 byte
+ * process count and each ID (4 byte length + bytes), 4 byte run count, then for each run its
+ * algorithm name (4 byte length + bytes), 4 byte CPU and wait interval counts and the intervals.
+ */
+class TimelineSink : public StreamSink {
+public:
+    TimelineSink(const std::string& stats_filename, int t_cs);
+
+    bool is_open() const { return stats_file.is_open(); }
+    bool wants_events() const { return true; }
+    void events(const Workload& workload, const EventLog& log);
+
+    const std::vector<Timeline>& timelines() const { return runs; }
+    // throws std::runtime_error if filename cannot be written
+    void write(const std::string& filename) const;
+
+private:
+    std::ofstream stats_file;
+    int t_cs;
+    std::vector<std::string> ids;
+    std::vector<Timeline> runs;
+};
+
+// answers query against a file TimelineSink::write() saved: a time in ms lists who was on the CPU
+// and who was queued then, a process ID lists its intervals; throws std::runtime_error when the
+// file is unreadable or the process unknown
+void query_timelines(const std::string& filename, const std::string& query, std::ostream& out);
+
+#endif //OPSYSPROJ_TIMELINE_H
@@ -0,0 +1,41 @@
+#include "trace.h"
+
+// "00" through "99", so two digits are produced per division
+static const char DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+size_t format_int(long long v, char* out) {
+    char tmp[20];
+    char* p = tmp + sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long) v : (unsigned long long) v;
+
+    while (u >= 100) {
+        unsigned idx = (unsigned) (u % 100) * 2;
+        u /= 100;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    }
+    if (u >= 10) {
+        unsigned idx = (unsigned) u * 2;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    } else {
+        *--p = (char) ('0' + u);
+    }
+    if (v < 0) {
+        *--p = '-';
+    }
+
+    size_t n = tmp + sizeof(tmp) - p;
+    std::memcpy(out, p, n);
+    return n;
+}
@@ -0,0 +1,83 @@
+#ifndef OPSYSPROJ_TRACE_H
+#define OPSYSPROJ_TRACE_H
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// writes v in decimal to out (which needs room for 20 chars) and returns the number of chars written
+size_t format_int(long long v, char* out);
+
+// appends an "s" when n > 1, for "1 burst" vs "2 bursts"
+struct Plural {
+    long long n;
+};
+
+inline Plural plural(long long n) {
+    Plural p = {n};
+    return p;
+}
+
+/*
+ * Reusable buffer a trace line is formatted into before it is written out in one go.
+ *
+ * Fields are appended straight into the buffer: string literals with their length known at
+ * compile time, PIDs by reference and integers through format_int, so building a line does no
+ * heap allocation once the buffer has grown to the longest line of the run.
+ */
+class TraceLine {
+public:
+    TraceLine() { buf.reserve(256); }
+
+    // clears the buffer and writes the "time <t>ms: " prefix every trace line starts with
+    TraceLine& start(long long time) {
+        buf.clear();
+        return *this << "time " << time << "ms: ";
+    }
+
+    template <size_t N>
+    TraceLine& operator<<(const char (&literal)[N]) {
+        append(literal, N - 1);
+        return *this;
+    }
+    TraceLine& operator<<(const std::string& s) {
+        append(s.data(), s.size());
+        return *this;
+    }
+    TraceLine& operator<<(char c) {
+        buf.push_back(c);
+        return *this;
+    }
+    TraceLine& operator<<(Plural p) {
+        if (p.n > 1) {
+            buf.push_back('s');
+        }
+        return *this;
+    }
+    TraceLine& operator<<(int v) {
+        return *this << (long long) v;
+    }
+    TraceLine& operator<<(long long v) {
+        char digits[20];
+        append(digits, format_int(v, digits));
+        return *this;
+    }
+
+    void append(const char* s, size_t n) {
+        buf.insert(buf.end(), s, s + n);
+    }
+
+    const char* data() const { return buf.data(); }
+    size_t size() const { return buf.size(); }
+
+    void write_to(std::ostream& out) const {
+        out.write(buf.data(), buf.size());
+    }
+
+private:
+    std::vector<char> buf;
+};
+
+#endif //OPSYSPROJ_TRACE_H
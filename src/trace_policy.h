@@ -0,0 +1,53 @@
+#ifndef OPSYSPROJ_TRACE_POLICY_H
+#define OPSYSPROJ_TRACE_POLICY_H
+
+#include "sim_time.h"
+
+/*
+ * Compile-time trace policies the scheduler event loops are instantiated with.
+ *
+ * enabled says whether the run traces at all (start / end / termination events are logged
+ * whenever it is set), windowed(t) whether an ordinary event at time t is logged. Both are
+ * constant expressions, so with TraceOff every logging branch folds away and the loop is
+ * compiled without any trace code.
+ *
+ * counted says whether the loop keeps PerfCounters (see perf_counters.h). It is false in the
+ * three policies below, so their loops carry no counting code; Counted<> turns it on.
+ */
+
+// how much a run traces, picked at runtime and mapped onto one of the policies below
+enum TraceLevel {
+    TRACE_OFF,
+    TRACE_CUTOFF,
+    TRACE_FULL
+};
+
+// nothing is logged
+struct TraceOff {
+    static constexpr bool enabled = false;
+    static constexpr bool counted = false;
+    static constexpr bool windowed(sim_time) { return false; }
+};
+
+// the project's usual output: everything up to CUTOFF ms, after that only terminations
+struct TraceCutoff {
+    static constexpr bool enabled = true;
+    static constexpr bool counted = false;
+    static constexpr int CUTOFF = 9999;
+    static constexpr bool windowed(sim_time time) { return time <= CUTOFF; }
+};
+
+// every event of the run
+struct TraceFull {
+    static constexpr bool enabled = true;
+    static constexpr bool counted = false;
+    static constexpr bool windowed(sim_time) { return true; }
+};
+
+// traces like Trace, and fills in the engine's PerfCounters as it goes
+template <class Trace>
+struct Counted : Trace {
+    static constexpr bool counted = true;
+};
+
+#endif //OPSYSPROJ_TRACE_POLICY_H
@@ -0,0 +1,128 @@
+#include "workload.h"
+#include <algorithm>
+#include <cstdint>
+#include "hash.h"
+
+
+// digits the arrival-time radix sort works through, 11 bits at a time so a count table stays in L1
+static const int RADIX_BITS = 11;
+static const uint32_t RADIX = 1u << RADIX_BITS;
+
+/*
+ * generation indices of processes in arrival order, ties kept in generation order: a stable
+ * LSD radix sort of the arrival times. Passes over a digit every key agrees on are skipped,
+ * so arrivals below 2^22 ms take two passes over the keys whatever n is
+ */
+static std::vector<int> arrival_order(const std::vector<Process>& processes) {
+    const size_t n = processes.size();
+    std::vector<uint32_t> key(n), next_key(n);
+    std::vector<int> order(n), next_order(n);
+    for (size_t j = 0; j < n; ++j) {
+        // flipping the sign bit makes unsigned order agree with int order
+        key[j] = (uint32_t) processes[j].arrival_time ^ 0x80000000u;
+        order[j] = (int) j;
+    }
+    std::vector<size_t> count(RADIX);
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        std::fill(count.begin(), count.end(), 0);
+        for (size_t j = 0; j < n; ++j) {
+            count[(key[j] >> shift) & (RADIX - 1)]++;
+        }
+        if (n == 0 || count[(key[0] >> shift) & (RADIX - 1)] == n) {
+            continue;
+        }
+        size_t start = 0;
+        for (uint32_t d = 0; d < RADIX; ++d) {
+            size_t c = count[d];
+            count[d] = start;
+            start += c;
+        }
+        for (size_t j = 0; j < n; ++j) {
+            size_t to = count[(key[j] >> shift) & (RADIX - 1)]++;
+            next_key[to] = key[j];
+            next_order[to] = order[j];
+        }
+        key.swap(next_key);
+        order.swap(next_order);
+    }
+    return order;
+}
+
+Workload::Workload(const std::vector<Process>& processes) {
+    const int n = (int) processes.size();
+    std::vector<int> order = arrival_order(processes);
+    size_t total_bursts = 0;
+    for (int j = 0; j < n; ++j) {
+        total_bursts += processes[j].bursts.size();
+    }
+
+    ids.reserve(n);
+    arrivals.reserve(n);
+    cpu_bound.reserve(n);
+    burst_offset.reserve(n + 1);
+    bursts.reserve(total_bursts);
+
+    BurstSummary empty = {0, 0, 0, 0, 0};
+    summaries[0] = summaries[1] = empty;
+
+    burst_offset.push_back(0);
+    for (int j = 0; j < n; ++j) {
+        const Process& p = processes[order[j]];
+        ids.push_back(p.id);
+        arrivals.push_back(p.arrival_time);
+        cpu_bound.push_back(p.is_cpu_bound ? 1 : 0);
+        bursts.insert(bursts.end(), p.bursts.begin(), p.bursts.end());
+        burst_offset.push_back((int) bursts.size());
+
+        // bursts alternate CPU, I/O, ..., so even positions sum to CPU time and odd ones to I/O time;
+        // the loop has no branches and works on bursts that were just copied, still in cache
+        const int count = (int) p.bursts.size();
+        const int* copied = bursts.data() + bursts.size() - count;
+        long long time[2] = {0, 0};
+        for (int k = 0; k < count; ++k) {
+            time[k & 1] += copied[k];
+        }
+        BurstSummary& summary = summaries[p.is_cpu_bound ? 1 : 0];
+        summary.processes++;
+        summary.cpu_time += time[0];
+        summary.io_time += time[1];
+        summary.cpu_bursts += (count + 1) / 2;
+        summary.io_bursts += count / 2;
+    }
+
+    // ranked once here, so the schedulers' tie-breaks never touch the strings
+    std::vector<int> by_id(n);
+    for (int h = 0; h < n; ++h) {
+        by_id[h] = h;
+    }
+    std::stable_sort(by_id.begin(), by_id.end(), [this](int a, int b) { return ids[a] < ids[b]; });
+    id_ranks.assign(n, 0);
+    for (int k = 1; k < n; ++k) {
+        id_ranks[by_id[k]] = ids[by_id[k]] == ids[by_id[k - 1]] ? id_ranks[by_id[k - 1]] : k;
+    }
+}
+
+std::vector<ProcState> Workload::initial_state(double tau) const {
+    std::vector<ProcState> state(size());
+    for (int h = 0; h < size(); ++h) {
+        state[h].tau = tau;
+        state[h].remaining = burst(h, 0);
+        state[h].burst_len = 0;
+        state[h].id_rank = id_ranks[h];
+        state[h].cursor = 0;
+        state[h].cpu_bound = cpu_bound[h];
+        state[h].unused = 0;
+    }
+    return state;
+}
+
+uint64_t Workload::content_hash() const {
+    uint64_t h = fnv1a_value(size());
+    for (int j = 0; j < size(); ++j) {
+        h = fnv1a_string(ids[j], h);
+    }
+    h = fnv1a(arrivals.data(), arrivals.size() * sizeof(int), h);
+    h = fnv1a(cpu_bound.data(), cpu_bound.size(), h);
+    h = fnv1a(burst_offset.data(), burst_offset.size() * sizeof(int), h);
+    return fnv1a(bursts.data(), bursts.size() * sizeof(int), h);
+}
@@ -0,0 +1,64 @@
+#ifndef OPSYSPROJ_WORKLOAD_H
+#define OPSYSPROJ_WORKLOAD_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "process.h"
+
+// burst totals over one class of process, what Part I of simout.txt averages
+struct BurstSummary {
+    int processes;
+    long long cpu_time, io_time;
+    int cpu_bursts, io_bursts;
+};
+
+/*
+ * Immutable, arrival-sorted view of a generated process set, shared by every scheduler.
+ *
+ * The data is stored structure-of-arrays: one column per Process field, with all bursts
+ * packed into a single pool and each process owning an [offset, offset + count) span of it.
+ * Processes are referred to by handle, which is their index in arrival order, so the
+ * schedulers only need small per-handle arrays for the state they actually mutate.
+ */
+class Workload {
+public:
+    explicit Workload(const std::vector<Process>& processes);
+
+    int size() const { return (int) arrivals.size(); }
+
+    const std::string& id(int h) const { return ids[h]; }
+    // position of the process's ID in sorted order, equal IDs equal ranks: comparing ranks
+    // orders processes as comparing their IDs would
+    int id_rank(int h) const { return id_ranks[h]; }
+    int arrival_time(int h) const { return arrivals[h]; }
+    bool is_cpu_bound(int h) const { return cpu_bound[h] != 0; }
+
+    // bursts alternate CPU, I/O, CPU, ... and always start and end with a CPU burst
+    int num_bursts(int h) const { return burst_offset[h + 1] - burst_offset[h]; }
+    int burst(int h, int k) const { return bursts[burst_offset[h] + k]; }
+    // the pool every process's bursts are packed into, process h's start at burst_pool()[first_burst(h)]
+    const int* burst_pool() const { return bursts.data(); }
+    int first_burst(int h) const { return burst_offset[h]; }
+
+    // totals for CPU-bound processes with cpu_bound set, else for I/O-bound ones; gathered while
+    // the burst pool is filled, so they cost no pass of their own
+    const BurstSummary& summary(bool cpu_bound) const { return summaries[cpu_bound ? 1 : 0]; }
+
+    // FNV-1a over every column, equal for equal process sets however they were generated
+    uint64_t content_hash() const;
+
+    // fresh scheduling state for every handle: cursor at the first burst, remaining set to it
+    std::vector<ProcState> initial_state(double tau) const;
+
+private:
+    std::vector<std::string> ids;
+    std::vector<int> id_ranks;
+    std::vector<int> arrivals;
+    std::vector<char> cpu_bound;
+    std::vector<int> burst_offset; // size() + 1 entries, process h owns [burst_offset[h], burst_offset[h + 1])
+    std::vector<int> bursts;
+    BurstSummary summaries[2]; // [0] is I/O-bound and [1] CPU-bound
+};
+
+#endif //OPSYSPROJ_WORKLOAD_H